@@ -56,9 +56,9 @@ UPDATE_FUNC(BOGGER) {
 
     push_rect(&game_state->main_render_group,
               color_ {0.67f, 0.54f, 0.23f},
-              entity->body->position,
+              phy_get_render_position(&game_state->physics_state, entity->body),
               bogger_diagonal,
-              entity->body->orientation,
+              phy_get_render_orientation(&game_state->physics_state, entity->body),
               0.5f,
               0);
 }
@@ -88,9 +88,9 @@ UPDATE_FUNC(BOGGER_BALL) {
     } else {
         push_rect(&game_state->main_render_group,
                   color_ {1.0f, 0.23f, 0.54f},
-                  entity->body->position,
+                  phy_get_render_position(&game_state->physics_state, entity->body),
                   bogger_ball_diagonal,
-                  entity->body->orientation,
+                  phy_get_render_orientation(&game_state->physics_state, entity->body),
                   0.5f,
                   0);        
     }
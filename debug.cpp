@@ -223,8 +223,10 @@ debug_push_ui_text_f(game_state_* game_state,
     return result;
 }
 
-void debug_draw_aabb_tree(game_state_* game_state) {
-    phy_aabb_tree_* tree = &game_state->physics_state.aabb_tree;
+void debug_draw_aabb_tree(game_state_* game_state, phy_aabb_tree_* tree, color_ color, f32 z) {
+    if (tree->nodes.count == 0) {
+        return;
+    }
 
     i32 stack[LARGE_STACK_SIZE] = {0};
 
@@ -240,12 +242,6 @@ void debug_draw_aabb_tree(game_state_* game_state) {
         v2 diagonal = aabb.max - aabb.min;
         v2 center = 0.5f * (aabb.max + aabb.min);
 
-        color_ color = node->is_asleep ?
-            color_ {0.5f,0.5f,0.5f} :
-            color_ {0.9f, 0.4f, 0.2f};
-
-        f32 z = node->is_asleep ? 0.01f : 0.0f;
-
         push_rect_outline(&game_state->main_render_group,
                           color,
                           center,
@@ -260,6 +256,17 @@ void debug_draw_aabb_tree(game_state_* game_state) {
     }
 }
 
+void debug_draw_aabb_trees(game_state_* game_state) {
+    debug_draw_aabb_tree(game_state,
+                         &game_state->physics_state.static_tree,
+                         color_ {0.5f,0.5f,0.5f},
+                         0.01f);
+    debug_draw_aabb_tree(game_state,
+                         &game_state->physics_state.dynamic_tree,
+                         color_ {0.9f, 0.4f, 0.2f},
+                         0.0f);
+}
+
 void
 debug_draw_hulls(game_state_* game_state) {
     phy_state_* physics = &game_state->physics_state;
@@ -353,6 +360,68 @@ void debug_update_and_render(game_state_* game_state,
                            tools_state,
                            window,
                            tools_state->debug_state.performance_log);
+
+        phy_state_* physics = &game_state->physics_state;
+        phy_broad_phase_stats_ broad_phase_stats = phy_get_broad_phase_stats(physics);
+        debug_easy_push_ui_text_f(game_state,
+                             tools_state,
+                             window,
+                             "broad phase: %s, tree %.0f cycles/step (%d steps), sap %.0f (%d)",
+                             physics->broad_phase == PHY_BROAD_PHASE_TREE
+                             ? "tree" : "sweep and prune",
+                             (f64)broad_phase_stats.cycles[PHY_BROAD_PHASE_TREE] /
+                             (f64)i32max(broad_phase_stats.steps[PHY_BROAD_PHASE_TREE], 1),
+                             broad_phase_stats.steps[PHY_BROAD_PHASE_TREE],
+                             (f64)broad_phase_stats.cycles[PHY_BROAD_PHASE_SAP] /
+                             (f64)i32max(broad_phase_stats.steps[PHY_BROAD_PHASE_SAP], 1),
+                             broad_phase_stats.steps[PHY_BROAD_PHASE_SAP]);
+        debug_easy_push_ui_text_f(game_state,
+                             tools_state,
+                             window,
+                             "solver: %s",
+                             physics->solver == PHY_SOLVER_BAUMGARTE
+                             ? "baumgarte" : "soft step");
+        debug_easy_push_ui_text_f(game_state,
+                             tools_state,
+                             window,
+                             "static tree: height %d, cost %.1f",
+                             aabb_tree_height(&physics->static_tree),
+                             (f64)aabb_tree_cost(&physics->static_tree));
+        debug_easy_push_ui_text_f(game_state,
+                             tools_state,
+                             window,
+                             "dynamic tree: height %d, cost %.1f",
+                             aabb_tree_height(&physics->dynamic_tree),
+                             (f64)aabb_tree_cost(&physics->dynamic_tree));
+        debug_easy_push_ui_text_f(game_state,
+                             tools_state,
+                             window,
+                             "bodies: %d awake, %d asleep",
+                             physics->dynamic_bodies.count,
+                             physics->sleeping_bodies.count);
+        phy_pair_cache_stats_ pair_stats = phy_get_pair_cache_stats(physics);
+        debug_easy_push_ui_text_f(game_state,
+                             tools_state,
+                             window,
+                             "pairs: %d/%d, %d hits, %d misses, %d evicted, axes %d/%d, %d reused",
+                             pair_stats.count,
+                             pair_stats.capacity,
+                             pair_stats.hits,
+                             pair_stats.misses,
+                             pair_stats.evictions,
+                             pair_stats.axis_hits,
+                             pair_stats.axis_hits + pair_stats.axis_misses,
+                             pair_stats.reuses);
+        phy_step_stats_ step_stats = phy_get_step_stats(physics);
+        debug_easy_push_ui_text_f(game_state,
+                             tools_state,
+                             window,
+                             "steps: %d, alpha %.2f, dropped %.1f ms (%.1f ms in %d frames)",
+                             step_stats.steps,
+                             (f64)physics->interpolation_alpha,
+                             (f64)(1000.0f * step_stats.dropped_time),
+                             (f64)(1000.0f * step_stats.total_dropped_time),
+                             step_stats.overruns);
     }
 
     if (tools_state->debug_state.draw_wireframes) {
@@ -367,14 +436,9 @@ void debug_update_and_render(game_state_* game_state,
         }
 
         if (tools_state->debug_state.selected) {
-
-            sim_entity_* entity =
-                get_hash_item_value(&game_state->entity_map,
-                                    tools_state->debug_state.selected->entity.id);
-
             push_circle(&game_state->main_render_group,
                         color_ {0.4f, 1.0f, 0.4f},
-                        entity->body->position,
+                        tools_state->debug_state.selected->position,
                         2.0f * VIRTUAL_PIXEL_SIZE,
                         0.0f,
                         0);
@@ -390,7 +454,7 @@ void debug_update_and_render(game_state_* game_state,
     }
 
     if (tools_state->debug_state.draw_aabb_tree) {
-        debug_draw_aabb_tree(game_state);
+        debug_draw_aabb_trees(game_state);
     }
 
     tools_state->debug_state.current_debug_text_bottom_left = debug_text_start(window);
@@ -41,9 +41,9 @@ UPDATE_FUNC(TURRET) {
 
     push_rect(&game_state->main_render_group,
               color_ {0.67f, 0.54f, 0.23f},
-              entity->body->position,
+              phy_get_render_position(&game_state->physics_state, entity->body),
               turret_diagonal,
-              entity->body->orientation,
+              phy_get_render_orientation(&game_state->physics_state, entity->body),
               0.5f,
               0);
 }
@@ -60,7 +60,7 @@ sim_entity_* create_turret_shot(game_state_* game_state, v2 position, v2 directi
                                                     0.09f,
                                                     turret_shot_mass,
                                                     turret_shot_orientation,
-                                                    PHY_WEIGHTLESS_FLAG);
+                                                    PHY_WEIGHTLESS_FLAG | PHY_BULLET_FLAG);
 
     shot->body->velocity = turret_shot_speed * direction;
     return shot;
@@ -78,9 +78,9 @@ UPDATE_FUNC(TURRET_SHOT) {
     } else {
         push_rect(&game_state->main_render_group,
                   color_ {1.0f, 0.23f, 0.54f},
-                  entity->body->position,
+                  phy_get_render_position(&game_state->physics_state, entity->body),
                   turret_shot_diagonal,
-                  entity->body->orientation,
+                  phy_get_render_orientation(&game_state->physics_state, entity->body),
                   0.5f,
                   0);        
     }
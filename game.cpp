@@ -157,6 +157,22 @@ setup_world(game_state_ *game_state) {
     i32 tile_map_width = i32(strchr(tile_map, '*') - tile_map + 1);
     i32 tile_map_height = ((i32)strlen(tile_map)) / tile_map_width;
 
+    // the solid tiles all collide through one tilemap, which merges them
+    // into a handful of big bodies
+    sim_entity_* tilemap_entity = add_entity(game_state);
+    tilemap_entity->body = 0;
+    tilemap_entity->type = TILEMAP;
+
+    phy_tilemap_* tilemap = phy_add_tilemap(&game_state->physics_state,
+                                            &game_state->world_arena,
+                                            v2 {0.0f, (f32)-tile_map_height},
+                                            tile_map_width,
+                                            tile_map_height,
+                                            1.0f,
+                                            PHY_GROUND_FLAG);
+    tilemap->entity.id = tilemap_entity->id;
+    tilemap->entity.type = TILEMAP;
+
     for (int y = 0; y < tile_map_height; ++y) {
         for (int x = 0; x < tile_map_width; ++x) {
             f32 tile_size = 1.0f;
@@ -175,6 +191,7 @@ setup_world(game_state_ *game_state) {
                         info.tex_coord_y = 1;
                     }
                     create_tile(game_state, position, info);
+                    phy_set_tile(tilemap, x, tile_map_height - 1 - y, true);
                 } break;
                 case 'M': {
                     i32 direction;
@@ -237,6 +254,9 @@ setup_world(game_state_ *game_state) {
         }
     }
 
+    phy_build_tilemap(&game_state->physics_state, tilemap);
+    phy_add_bodies_bulk(&game_state->physics_state);
+
     game_state->gravity_normal = v2 {0.0f, -1.0f};
     game_state->gravity_magnitude = BASE_GRAVITY_MAGNITUDE;
 
@@ -280,7 +300,8 @@ initialize_game_state(game_state_* game_state, window_description_ window) {
     game_state->ui_camera.orientation = 0.0f;
     game_state->ui_camera.zoom.factor = 1.0f;
 
-    game_state->physics_state = phy_init(&game_state->world_arena);
+    game_state->physics_state = phy_init(&game_state->world_arena,
+                                         PHY_BROAD_PHASE_TREE);
 
     const i32 entity_capacity = 4000;
     game_state->entities.allocate(&game_state->world_arena, entity_capacity);
@@ -324,12 +345,13 @@ game_update_and_render(platform_services_ platform,
     }
 
     if (!game_state->paused || game_state->advance_one_frame) {
-        clear_hashmap(&game_state->collision_map);
-
         phy_set_gravity(&game_state->physics_state, 
                         game_state->gravity_magnitude * game_state->gravity_normal);
 
-        phy_update(&game_state->physics_state, &game_state->collision_map, dt);
+        phy_update(&game_state->physics_state,
+                   &game_state->collision_map,
+                   dt,
+                   &platform);
 
         for (int i = 0; i < game_state->entities.size; ++i) {
 			TIMED_BLOCK(update_entities);
@@ -357,6 +379,7 @@ game_update_and_render(platform_services_ platform,
                 __EMPTY_CASE(BOGGER_BALL);
                 __EMPTY_CASE(WIZ_BUZZ);
                 __EMPTY_CASE(SAVE_POINT);
+                __EMPTY_CASE(TILEMAP);
             }
         }
 
@@ -139,8 +139,8 @@ UPDATE_FUNC(LILGUY) {
     animation_* animation = game_state->main_animation_group.animations
         .at(state->animation_index);
 
-    animation->position = entity->body->position;
-    animation->orientation = entity->body->orientation;
+    animation->position = phy_get_render_position(&game_state->physics_state, entity->body);
+    animation->orientation = phy_get_render_orientation(&game_state->physics_state, entity->body);
 
     if (state->flags != previous_flags) {
         reset_animation(animation, get_animation(game_state, state->flags));
@@ -9,23 +9,88 @@
 #include "renderer.h"
 
 phy_state_
-phy_init(memory_arena_* memory) {
+phy_init(memory_arena_* memory, phy_broad_phase_ broad_phase) {
     phy_state_ result;
 
-    result.time_step = 1.0f / 240.0f;
+    result.broad_phase = broad_phase;
+    result.gravity = v2 {0.0f, 0.0f};
+    result.wake_gravity = v2 {0.0f, 0.0f};
+    ZERO_STRUCT(result.broad_phase_stats);
+    result.broad_phase_switched = false;
+
+    result.time_step = SOLVER_TIME_STEP;
+    result.current_time = 0.0f;
+    result.velocity_iterations = SOLVER_VELOCITY_ITERATIONS;
+    result.solver = PHY_SOLVER_BAUMGARTE;
+    result.substeps = SOFT_STEP_SUBSTEPS;
+    ZERO_STRUCT(result.softness);
+    result.accumulator = 0.0f;
+    result.interpolation_alpha = 0.0f;
+    result.snapshot_id = 0;
+    result.step_policy = PHY_STEP_CLAMP;
+    result.max_substeps = 12;
+    result.max_frame_time = 0.1f;
+    ZERO_STRUCT(result.step_stats);
 
     result.bodies.init(memory, 4000);
+    result.new_bodies.init(memory, 4000);
+    result.dynamic_bodies.init(memory, 4000);
+    result.sleeping_bodies.init(memory, 4000);
+    result.wake_list.init(memory, 4000);
+    result.island_parents.init(memory, 4000);
+    result.island_sleep_times.init(memory, 4000);
+    result.solver_body_colors.init(memory, 4000);
+    result.solver_collision_colors.init(memory, 4000);
+    result.solver_colors.init(memory, SOLVER_MAX_COLORS);
+    result.solver_tasks.init(memory, SOLVER_MAX_TASKS);
     result.previous_velocities.init(memory, 4000);
     result.previous_angular_velocities.init(memory, 4000);
     result.hulls.init(memory, 4000);
     result.points.init(memory, 4000);
     result.collisions.init(memory, 4000);
     result.potential_collisions.init(memory, 4000);
-    result.manifold_cache.pairs.init(memory, 4000);
-
-    result.aabb_tree.nodes.init(memory, 8000);
-    result.aabb_tree.checked_parents.init(memory, 8000);
-    result.aabb_tree.dead_nodes.init(memory, 8000);
+    result.narrow_results.init(memory, 4000);
+    result.narrow_tasks.init(memory, NARROW_PHASE_MAX_TASKS);
+    pair_cache_init(&result.pair_cache, memory, PAIR_CACHE_INITIAL_CAPACITY);
+
+    result.move_buffer.init(memory, 4000);
+    result.pairs.init(memory, 8000);
+    result.new_pairs.init(memory, 8000);
+    result.pair_scratch.init(memory, 8000);
+    result.build_leaves.init(memory, 8000);
+    result.build_nodes.init(memory, 8000);
+    result.tilemaps.init(memory, 16);
+
+    sap_init_intervals(&result.sap.dynamic_intervals, memory, 4000);
+    sap_init_intervals(&result.sap.static_intervals, memory, 8000);
+
+    // every color can leave up to three lanes of padding
+    solver_init_manifolds(&result.solver_manifolds, memory,
+                          4000 + 3 * SOLVER_MAX_COLORS);
+    // dynamic bodies, a slot per fixed body per manifold, and the empty slot
+    solver_init_bodies(&result.solver_bodies, memory, 4000 + 4000 + 1);
+
+    result.static_tree.nodes.init(memory, 8000);
+    result.static_tree.dead_nodes.init(memory, 8000);
+    result.dynamic_tree.nodes.init(memory, 8000);
+    result.dynamic_tree.dead_nodes.init(memory, 8000);
+    result.static_tree.wide.nodes.init(memory, 4000, 64);
+    result.static_tree.wide.children.init(memory, 4000);
+    result.dynamic_tree.wide.nodes.init(memory, 4000, 64);
+    result.dynamic_tree.wide.children.init(memory, 4000);
+    result.static_tree.root = -1;
+    result.dynamic_tree.root = -1;
+    result.static_tree.version = 1;
+    result.dynamic_tree.version = 1;
+    result.static_tree.wide.version = 0;
+    result.dynamic_tree.wide.version = 0;
+    result.static_tree.optimize_path = 0;
+    result.dynamic_tree.optimize_path = 0;
+
+    // the static tree comes out of the bulk build already better than
+    // reinserting would make it, and it's never refit, so leave it alone
+    result.static_tree.optimize_budget = 0;
+    result.dynamic_tree.optimize_budget = 4;
 
     return result;
 }
@@ -191,9 +256,9 @@ do_support(phy_hull_* a, phy_hull_* b, v2 direction) {
 }
 
 inline f32
-area(phy_aabb_ aabb) {
+perimeter(phy_aabb_ aabb) {
     v2 vec = aabb.max - aabb.min;
-    return vec.x * vec.y;
+    return 2.0f * (vec.x + vec.y);
 }
 
 inline b32
@@ -215,337 +280,424 @@ aabb_is_contained_in(v2 p, phy_aabb_ aabb) {
            p.x <= aabb.max.x && p.y <= aabb.max.y;
 }
 
-phy_aabb_tree_node_*
-aabb_insert_node(phy_aabb_tree_* tree,
-            i32 parent_index,
-            phy_aabb_ fat_aabb,
-            phy_body_* body,
-            b32 is_asleep) {
-    phy_aabb_tree_node_* result;
-    b32 found_leaf = false;
-    while (!found_leaf) {
-        phy_aabb_tree_node_ *parent = tree->nodes.at(parent_index);
-        if (parent->type == LEAF_NODE) {
-            // if parent is a leaf, split it - transfer the parent's data into
-            // the left child and set up our new node as the right child
-            i32 left_index;
-            if (tree->dead_nodes.count) {
-                left_index = tree->dead_nodes[--tree->dead_nodes.count];
-            }
-            else {
-                left_index = tree->nodes.push_unassigned();
-            }
-            i32 right_index;
-            if (tree->dead_nodes.count) {
-                right_index = tree->dead_nodes[--tree->dead_nodes.count];
-            }
-            else {
-                right_index = tree->nodes.push_unassigned();
-            }
-            phy_aabb_tree_node_ *left = tree->nodes.at(left_index);
-            phy_aabb_tree_node_ *right = tree->nodes.at(right_index);
-            phy_body_* parent_body = parent->body;
-            parent->left = left_index;
-            parent->right = right_index;
-
-            left->parent = parent_index;
-            left->fat_aabb = parent->fat_aabb;
-            left->is_asleep = parent->is_asleep;
-            left->body = parent_body;
-            left->type = LEAF_NODE;
-
-            right->parent = parent_index;
-            right->fat_aabb = fat_aabb;
-            right->body = body;
-            right->type = LEAF_NODE;
-            right->is_asleep = is_asleep;
-
-            found_leaf = true;
-        } else {
-            phy_aabb_tree_node_ *left = tree->nodes.at(parent->left);
-            phy_aabb_tree_node_ *right = tree->nodes.at(parent->right);
+inline i32
+aabb_allocate_node(phy_aabb_tree_* tree) {
+    i32 result = tree->dead_nodes.count
+                 ? tree->dead_nodes[--tree->dead_nodes.count]
+                 : tree->nodes.push_unassigned();
+    tree->nodes.at(result)->moved = false;
+    return result;
+}
+
+// the tree cost is the sum of the perimeters of all internal nodes (the 2d
+// surface area heuristic). this walks down from the root looking for the
+// sibling that adds the least to it. the cost a subtree inherits is how much
+// its ancestors grow by taking the new leaf, so any subtree whose inherited
+// cost plus the leaf's own perimeter can't beat the best found so far is
+// skipped entirely
+i32
+aabb_find_best_sibling(phy_aabb_tree_* tree, phy_aabb_ fat_aabb) {
+    TIMED_FUNC();
 
-            phy_aabb_ left_union = get_union(left->fat_aabb, fat_aabb);
-            phy_aabb_ right_union = get_union(right->fat_aabb, fat_aabb);
+    f32 leaf_cost = perimeter(fat_aabb);
 
-            parent_index = area(left_union) < area(right_union)
-                           ? parent->left
-                           : parent->right;
+    i32 best_index = tree->root;
+    f32 best_cost = perimeter(get_union(tree->nodes.at(tree->root)->fat_aabb,
+                                        fat_aabb));
+
+    tuple2<i32, f32> stack[MEDIUM_STACK_SIZE];
+    i32 stack_index = 0;
+    stack[stack_index++] = tuple2<i32, f32> {tree->root, 0.0f};
+
+    while (stack_index > 0) {
+        tuple2<i32, f32> entry = stack[--stack_index];
+        phy_aabb_tree_node_* node = tree->nodes.at(entry.first);
+
+        f32 direct_cost = perimeter(get_union(node->fat_aabb, fat_aabb));
+        f32 cost = direct_cost + entry.second;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_index = entry.first;
+        }
+
+        if (node->type != LEAF_NODE) {
+            f32 inherited_cost = entry.second + direct_cost -
+                                 perimeter(node->fat_aabb);
+            if (leaf_cost + inherited_cost < best_cost) {
+                assert_(stack_index + 2 <= (i32)ARRAY_SIZE(stack));
+                stack[stack_index++] = tuple2<i32, f32> {node->left,
+                                                          inherited_cost};
+                stack[stack_index++] = tuple2<i32, f32> {node->right,
+                                                          inherited_cost};
+            }
         }
     }
 
-    result = tree->nodes.at(parent_index);
+    return best_index;
+}
+
+inline void
+aabb_refit_node(phy_aabb_tree_* tree, phy_aabb_tree_node_* node) {
+    phy_aabb_tree_node_ *left = tree->nodes.at(node->left);
+    phy_aabb_tree_node_ *right = tree->nodes.at(node->right);
+    node->fat_aabb = get_union(left->fat_aabb, right->fat_aabb);
+    node->height = 1 + i32max(left->height, right->height);
+}
 
-    while (parent_index != -1) {
-        phy_aabb_tree_node_ *parent = tree->nodes.at(parent_index);
-        phy_aabb_tree_node_ *left = tree->nodes.at(parent->left);
-        phy_aabb_tree_node_ *right = tree->nodes.at(parent->right);
-        parent->fat_aabb = get_union(left->fat_aabb, right->fat_aabb);
-        parent->is_asleep = left->is_asleep && right->is_asleep;
-        parent_index = parent->parent;
+// swaps child, a child of node, with grandchild, a child of node's other
+// child inner. node's bounds don't change but inner's do
+void
+aabb_swap_nodes(phy_aabb_tree_* tree,
+                i32 node_index,
+                i32 child_index,
+                i32 inner_index,
+                i32 grandchild_index) {
+    phy_aabb_tree_node_* node = tree->nodes.at(node_index);
+    phy_aabb_tree_node_* inner = tree->nodes.at(inner_index);
+
+    if (node->left == child_index) {
+        node->left = grandchild_index;
+    } else {
+        node->right = grandchild_index;
     }
 
-    return result;
+    if (inner->left == grandchild_index) {
+        inner->left = child_index;
+    } else {
+        inner->right = child_index;
+    }
+
+    tree->nodes.at(child_index)->parent = inner_index;
+    tree->nodes.at(grandchild_index)->parent = node_index;
+
+    aabb_refit_node(tree, inner);
+    aabb_refit_node(tree, node);
 }
 
-void aabb_remove_node(phy_aabb_tree_ *tree, i32 index) {
-    TIMED_FUNC();
+// tries the four ways of swapping a child of node with a grandchild on the
+// other side, and applies whichever shrinks the perimeter of the internal
+// node it touches the most
+void
+aabb_rotate_node(phy_aabb_tree_* tree, i32 node_index) {
+    phy_aabb_tree_node_* node = tree->nodes.at(node_index);
+    if (node->type == LEAF_NODE || node->height < 2) {
+        return;
+    }
 
-    i32 parent_index = tree->nodes[index].parent;
-    if (parent_index == -1) {
-        // if parent index is -1, we're removing the root. just kill the tree
-        assert_(tree->nodes.count == 1);
-        tree->nodes.count = 0;
-        tree->dead_nodes.count = 0;
-    } else {
-        phy_aabb_tree_node_ *parent = tree->nodes.at(parent_index);
-        i32 sibling_index = (parent->left == index) ? parent->right
-                                                    : parent->left;
-        phy_aabb_tree_node_ *sibling = tree->nodes.at(sibling_index);
-        if (parent->parent != -1) {
-            // if we have a grand parent, then replace the parent node with
-            // the sibling of the node we're removing
-            phy_aabb_tree_node_ *grandparent = tree->nodes.at(parent->parent);
-            sibling->parent = parent->parent;
-            i32 parent_was_right = grandparent->right == parent_index;
-            if (parent_was_right) {
-                grandparent->right = sibling_index;
-            } else {
-                grandparent->left = sibling_index;
-            }
-        } else {
-            tree->root = sibling_index;
-            tree->nodes.at(tree->root)->parent = -1;
+    i32 b_index = node->left;
+    i32 c_index = node->right;
+    phy_aabb_tree_node_* b = tree->nodes.at(b_index);
+    phy_aabb_tree_node_* c = tree->nodes.at(c_index);
+
+    i32 best_child = -1;
+    i32 best_inner = -1;
+    i32 best_grandchild = -1;
+    f32 best_gain = 0.0f;
+
+    if (c->type != LEAF_NODE) {
+        phy_aabb_tree_node_* f = tree->nodes.at(c->left);
+        phy_aabb_tree_node_* g = tree->nodes.at(c->right);
+        f32 c_cost = perimeter(c->fat_aabb);
+
+        f32 gain = c_cost - perimeter(get_union(b->fat_aabb, g->fat_aabb));
+        if (gain > best_gain) {
+            best_gain = gain;
+            best_child = b_index;
+            best_inner = c_index;
+            best_grandchild = c->left;
+        }
+
+        gain = c_cost - perimeter(get_union(b->fat_aabb, f->fat_aabb));
+        if (gain > best_gain) {
+            best_gain = gain;
+            best_child = b_index;
+            best_inner = c_index;
+            best_grandchild = c->right;
+        }
+    }
+
+    if (b->type != LEAF_NODE) {
+        phy_aabb_tree_node_* d = tree->nodes.at(b->left);
+        phy_aabb_tree_node_* e = tree->nodes.at(b->right);
+        f32 b_cost = perimeter(b->fat_aabb);
+
+        f32 gain = b_cost - perimeter(get_union(c->fat_aabb, e->fat_aabb));
+        if (gain > best_gain) {
+            best_gain = gain;
+            best_child = c_index;
+            best_inner = b_index;
+            best_grandchild = b->left;
+        }
+
+        gain = b_cost - perimeter(get_union(c->fat_aabb, d->fat_aabb));
+        if (gain > best_gain) {
+            best_gain = gain;
+            best_child = c_index;
+            best_inner = b_index;
+            best_grandchild = b->right;
         }
-        tree->dead_nodes.push(parent_index);
-        tree->dead_nodes.push(index);
     }
 
-    while (parent_index != -1) {
-        phy_aabb_tree_node_ *parent = tree->nodes.at(parent_index);
-        phy_aabb_tree_node_ *left = tree->nodes.at(parent->left);
-        phy_aabb_tree_node_ *right = tree->nodes.at(parent->right);
-        parent->fat_aabb = get_union(left->fat_aabb, right->fat_aabb);
-        parent->is_asleep = left->is_asleep && right->is_asleep;
-        parent_index = parent->parent;
+    if (best_child != -1) {
+        aabb_swap_nodes(tree, node_index, best_child, best_inner,
+                        best_grandchild);
     }
 }
 
-phy_aabb_
-get_aabb(phy_body_ *body) {
+// walks from index up to the root, rotating and refitting each ancestor
+void
+aabb_refit_ancestors(phy_aabb_tree_* tree, i32 index) {
+    while (index != -1) {
+        phy_aabb_tree_node_* node = tree->nodes.at(index);
+        aabb_refit_node(tree, node);
+        aabb_rotate_node(tree, index);
+        index = node->parent;
+    }
+}
+
+// links an already allocated leaf into the tree. leaf indices never change
+// once allocated, so bodies can hold on to theirs
+void
+aabb_insert_leaf(phy_aabb_tree_* tree, i32 leaf_index) {
     TIMED_FUNC();
 
-    phy_aabb_ result;
-    result.min = v2 {FLT_MAX, FLT_MAX};
-    result.max = v2 {-FLT_MAX, -FLT_MAX};
-    m2x2 rotation = get_rotation_matrix(body->orientation);
-    for (int i = 0; i < body->hulls.count; ++i) {
-        phy_hull_ *hull = body->hulls.at(i);
+    ++tree->version;
 
-        switch (hull->type) {
-            case HULL_MESH: {
-                for (int j = 0; j < hull->points.count; ++j) {
-                    v2 p = hull->position + rotation * hull->points[j];
-                    if (p.x < result.min.x) { result.min.x = p.x; }
-                    if (p.y < result.min.y) { result.min.y = p.y; }
-                    if (p.x > result.max.x) { result.max.x = p.x; }
-                    if (p.y > result.max.y) { result.max.y = p.y; }
-                }
-            } break;
-            default: {
-                result.min.x = do_support(hull, v2 {-1.0f, 0.0f}).x;
-                result.max.x = do_support(hull, v2 {1.0f, 0.0f}).x;
-                result.min.y = do_support(hull, v2 {0.0f, -1.0f}).y;
-                result.max.y = do_support(hull, v2 {0.0f, 1.0f}).y;
-            } break;
-        }
+    phy_aabb_tree_node_* leaf = tree->nodes.at(leaf_index);
+
+    if (tree->root == -1) {
+        tree->root = leaf_index;
+        leaf->parent = -1;
+        return;
     }
-    return result;
-}
 
-ray_intersect_
-ray_segment_intersect(v2 p, v2 d, v2 a, v2 b) {
-    v2 v_1 = p - a;
-    v2 v_2 = b - a;
-    v2 v_3 = perp(d);
-    f32 t_1 = flt_cross(v_2, v_1) / dot(v_2, v_3);
-    f32 t_2 = dot(v_1, v_3) / dot(v_2, v_3);
-    ray_intersect_ result;
-    result.intersecting = t_2 >= 0.0f && t_2 <= 1.0f && t_1 >= 0.0f;
+    i32 sibling_index = aabb_find_best_sibling(tree, leaf->fat_aabb);
 
-    result.depth = t_1;
-    return result;
-}
+    i32 parent_index = aabb_allocate_node(tree);
+    leaf = tree->nodes.at(leaf_index);
+    phy_aabb_tree_node_* sibling = tree->nodes.at(sibling_index);
+    phy_aabb_tree_node_* parent = tree->nodes.at(parent_index);
 
-inline ray_intersect_
-ray_aabb_intersect(v2 p, v2 d, phy_aabb_ aabb) {
-    ray_intersect_ result;
-    result.intersecting = false;
+    i32 old_parent_index = sibling->parent;
+    parent->parent = old_parent_index;
+    parent->left = sibling_index;
+    parent->right = leaf_index;
+    sibling->parent = parent_index;
+    leaf->parent = parent_index;
 
-    if (aabb_is_contained_in(p, aabb)) {
-        result.intersecting = true;
-        result.depth = 0;
+    if (old_parent_index == -1) {
+        tree->root = parent_index;
     } else {
-        if (p.x <= aabb.min.x) {
-            f32 t = (aabb.min.x - p.x) / d.x;
-            f32 y = p.y + t * d.y;
+        phy_aabb_tree_node_* old_parent = tree->nodes.at(old_parent_index);
+        if (old_parent->left == sibling_index) {
+            old_parent->left = parent_index;
+        } else {
+            old_parent->right = parent_index;
+        }
+    }
 
-            if (t > 0.0f && y >= aabb.min.y && y <= aabb.max.y) {
-                result.intersecting = true;
-                result.depth = t;
-            }
-        } else if(!result.intersecting && p.x >= aabb.max.x) {
-            f32 t = (aabb.max.x - p.x) / d.x;
-            f32 y = p.y + t * d.y;
+    aabb_refit_ancestors(tree, parent_index);
+}
 
-            if (t > 0.0f && y >= aabb.min.y && y <= aabb.max.y) {
-                result.intersecting = true;
-                result.depth = t;
-            }
-        }
+// unlinks a leaf from the tree without freeing it
+void
+aabb_remove_leaf(phy_aabb_tree_* tree, i32 leaf_index) {
+    TIMED_FUNC();
 
-        if(!result.intersecting && p.y <= aabb.min.y) {
-            f32 t = (aabb.min.y - p.y) / d.y;
-            f32 x = p.x + t * d.x;
+    ++tree->version;
 
-            if (t > 0.0f && x >= aabb.min.x && x <= aabb.max.x) {
-                result.intersecting = true;
-                result.depth = t;
-            }
-        } else if (!result.intersecting && p.y >= aabb.max.y) {
-            f32 t = (aabb.max.y - p.y) / d.y;
-            f32 x = p.x + t * d.x;
+    if (tree->root == leaf_index) {
+        tree->root = -1;
+        return;
+    }
 
-            if (t > 0.0f && x >= aabb.min.x && x <= aabb.max.x) {
-                result.intersecting = true;
-                result.depth = t;
-            }
+    i32 parent_index = tree->nodes.at(leaf_index)->parent;
+    phy_aabb_tree_node_ *parent = tree->nodes.at(parent_index);
+    i32 grandparent_index = parent->parent;
+    i32 sibling_index = (parent->left == leaf_index) ? parent->right
+                                                     : parent->left;
+    phy_aabb_tree_node_ *sibling = tree->nodes.at(sibling_index);
+
+    sibling->parent = grandparent_index;
+    if (grandparent_index == -1) {
+        tree->root = sibling_index;
+    } else {
+        // replace the parent node with the sibling of the leaf
+        phy_aabb_tree_node_ *grandparent = tree->nodes.at(grandparent_index);
+        if (grandparent->left == parent_index) {
+            grandparent->left = sibling_index;
+        } else {
+            grandparent->right = sibling_index;
         }
     }
-    return result;
+    tree->dead_nodes.push(parent_index);
+
+    aabb_refit_ancestors(tree, grandparent_index);
 }
 
-inline ray_intersect_
-ray_body_intersect(v2 p, v2 d, phy_body_* body) {
-    ray_intersect_ result;
-    result.intersecting = false;
-    for (int i = 0; i < body->hulls.count; ++i) {
-        ray_intersect_ r = ray_hull_intersect(p,d,body->hulls.at(i));
+// makes a leaf for body without linking it into the tree
+i32
+aabb_allocate_leaf(phy_aabb_tree_* tree,
+                   phy_aabb_ fat_aabb,
+                   phy_body_* body) {
+    i32 index = aabb_allocate_node(tree);
+    phy_aabb_tree_node_* node = tree->nodes.at(index);
+    node->body = body;
+    node->type = LEAF_NODE;
+    node->height = 0;
+    node->fat_aabb = fat_aabb;
+    node->parent = -1;
+    return index;
+}
 
-        if (!r.intersecting || (result.intersecting && result.depth < r.depth)) { continue; }
+i32
+aabb_insert_node(phy_aabb_tree_* tree,
+                 phy_aabb_ fat_aabb,
+                 phy_body_* body) {
+    TIMED_FUNC();
 
-        result = r;
-    }
-    return result;
+    i32 index = aabb_allocate_leaf(tree, fat_aabb, body);
+    aabb_insert_leaf(tree, index);
+    return index;
 }
 
-b32 hull_contains_point(phy_hull_* hull, v2 p) {
-    switch (hull->type) {
-        case HULL_MESH: {
-            assert_(false);
-        } break;
-        case HULL_RECT: {
-            v2 p_local = rotate(p - hull->position, -hull->orientation);
-            f32 width = hull->width;
-            f32 height = hull->height;
-            if (p_local.x >= -width / 2.0f && p_local.x <= width / 2.0f &&
-                p_local.y >= -height / 2.0f && p_local.y <= height / 2.0f) {
-                return true;
-            }
-        } break;
-        case HULL_FILLET_RECT: {
+void
+aabb_remove_node(phy_aabb_tree_ *tree, i32 index) {
+    TIMED_FUNC();
 
-            // TODO(doug): ignoring the fillet for now. will come back to it later
-            v2 p_local = rotate(p - hull->position, -hull->orientation);
-            f32 width = hull->width;
-            f32 height = hull->height;
-            if (p_local.x >= -width / 2.0f && p_local.x <= width / 2.0f &&
-                p_local.y >= -height / 2.0f && p_local.y <= height / 2.0f) {
-                return true;
-            }
-        } break;
+    aabb_remove_leaf(tree, index);
+
+    if (tree->root == -1) {
+        // that was the last leaf, so everything else is dead. just kill the
+        // tree
+        tree->nodes.count = 0;
+        tree->dead_nodes.count = 0;
+    } else {
+        tree->dead_nodes.push(index);
     }
-    return false;
 }
 
-b32 body_contains_point(phy_body_* body, v2 p) {
-    for (int i = 0; i < body->hulls.count; ++i) {
-        if (hull_contains_point(body->hulls.at(i), p)) {
-            return true;
+void
+aabb_move_node(phy_aabb_tree_* tree, i32 index, phy_aabb_ fat_aabb) {
+    TIMED_FUNC();
+
+    aabb_remove_leaf(tree, index);
+    tree->nodes.at(index)->fat_aabb = fat_aabb;
+    aabb_insert_leaf(tree, index);
+}
+
+// flags every ancestor of a leaf whose fat aabb changed, so that
+// aabb_refit_moved can fix them all up at once. stops at the first ancestor
+// that's already flagged, since everything above it is too
+void
+aabb_mark_moved(phy_aabb_tree_* tree, i32 index) {
+    index = tree->nodes.at(index)->parent;
+    while (index != -1) {
+        phy_aabb_tree_node_* node = tree->nodes.at(index);
+        if (node->moved) {
+            break;
         }
+        node->moved = true;
+        index = node->parent;
     }
-
-    return false;
 }
 
-phy_body_* pick_body(phy_state_* state, v2 p) {
-    phy_body_* result = 0;
+// refits and rotates every flagged node bottom up, visiting each one once.
+// a node is only refit after both of its children are
+void
+aabb_refit_moved(phy_aabb_tree_* tree) {
+    TIMED_FUNC();
 
-    phy_aabb_tree_* tree = &state->aabb_tree;
-    i32 stack[MEDIUM_STACK_SIZE] = {0};
+    if (tree->root == -1 || !tree->nodes.at(tree->root)->moved) {
+        return;
+    }
+
+    ++tree->version;
 
+    // the second value is whether the node's children have been pushed yet
+    tuple2<i32, b32> stack[MEDIUM_STACK_SIZE];
     i32 stack_index = 0;
-    stack[stack_index++] = tree->root;
+    stack[stack_index++] = tuple2<i32, b32> {tree->root, false};
 
     while (stack_index > 0) {
-        assert((size_t)stack_index < ARRAY_SIZE(stack));
-
-        phy_aabb_tree_node_* node = tree->nodes.at(stack[--stack_index]);
-
-        phy_aabb_ aabb = node->fat_aabb;
-        if (p.x >= aabb.min.x && p.y >= aabb.min.y &&
-            p.x <= aabb.max.x && p.y <= aabb.max.y) {
-            if (node->type == LEAF_NODE) {
-                phy_body_* body = node->body;
-                if (body_contains_point(body, p)) {
-                    result = body;
-                    break;
+        tuple2<i32, b32>* entry = &stack[stack_index - 1];
+        phy_aabb_tree_node_* node = tree->nodes.at(entry->first);
+
+        if (entry->second) {
+            --stack_index;
+            aabb_refit_node(tree, node);
+            aabb_rotate_node(tree, entry->first);
+            node->moved = false;
+        } else {
+            entry->second = true;
+            i32 children[] = {node->left, node->right};
+            for (u32 i = 0; i < ARRAY_SIZE(children); ++i) {
+                phy_aabb_tree_node_* child = tree->nodes.at(children[i]);
+                if (child->type != LEAF_NODE && child->moved) {
+                    assert_(stack_index < (i32)ARRAY_SIZE(stack));
+                    stack[stack_index++] = tuple2<i32, b32> {children[i],
+                                                             false};
                 }
-            } else {
-                stack[stack_index++] = node->left;
-                stack[stack_index++] = node->right;
             }
         }
     }
-
-    return result;
 }
 
-ray_body_intersect_ ray_cast(phy_state_* state,
-                              v2 p,
-                              v2 d,
-                              u32 required_flags,
-                              phy_body_* exclude) {
-    phy_aabb_tree_* tree = &state->aabb_tree;
+// incrementally improves the tree by reinserting up to leaf_count leaves.
+// leaves are picked by walking down from the root following the bits of
+// optimize_path, which is bumped every pass so that successive calls end up
+// visiting the whole tree. this is where leaves inserted in a bad order
+// (like the tile map, which goes in row by row) get moved somewhere better
+void
+aabb_optimize_incremental(phy_aabb_tree_* tree, i32 leaf_count) {
+    TIMED_FUNC();
 
-    ray_body_intersect_ result = {0};
-    i32 stack[MEDIUM_STACK_SIZE] = {0};
+    if (tree->nodes.count == 0) {
+        return;
+    }
 
-    i32 stack_index = 0;
-    stack[stack_index++] = tree->root;
+    for (i32 i = 0; i < leaf_count; ++i) {
+        i32 index = tree->root;
+        u32 bit = 0;
+        while (tree->nodes.at(index)->type != LEAF_NODE) {
+            phy_aabb_tree_node_* node = tree->nodes.at(index);
+            index = ((tree->optimize_path >> bit) & 1) ? node->right
+                                                       : node->left;
+            bit = (bit + 1) & 31;
+        }
 
-    while (stack_index > 0) {
-        assert((size_t)stack_index < ARRAY_SIZE(stack));
-        phy_aabb_tree_node_* node = tree->nodes.at(stack[--stack_index]);
-        ray_intersect_ r = ray_aabb_intersect(p, d, node->fat_aabb);
-        if (!r.intersecting || (result.body && result.depth < r.depth)) {
-            continue;
+        if (index == tree->root) {
+            return;
         }
 
-        if (node->type == LEAF_NODE) {
-            phy_body_* body = node->body;
-            if (!body || body == exclude) { continue; }
-            if ((body->flags & required_flags) != required_flags) { continue; }
+        aabb_remove_leaf(tree, index);
+        aabb_insert_leaf(tree, index);
+        ++tree->optimize_path;
+    }
+}
 
-            r = ray_body_intersect(p, d, body);
+i32
+aabb_tree_height(phy_aabb_tree_* tree) {
+    return tree->nodes.count ? tree->nodes.at(tree->root)->height : 0;
+}
 
-            if (!r.intersecting || (result.body && result.depth < r.depth)) {
-                continue;
-            }
+// the surface area heuristic cost of the whole tree. lower is better
+f32
+aabb_tree_cost(phy_aabb_tree_* tree) {
+    f32 result = 0.0f;
+    if (tree->nodes.count == 0) {
+        return result;
+    }
 
-            result.body = body;
-            result.depth = r.depth;
-        } else {
+    i32 stack[LARGE_STACK_SIZE];
+    i32 stack_index = 0;
+    stack[stack_index++] = tree->root;
+
+    while (stack_index > 0) {
+        phy_aabb_tree_node_* node = tree->nodes.at(stack[--stack_index]);
+        if (node->type != LEAF_NODE) {
+            assert_(stack_index + 2 <= (i32)ARRAY_SIZE(stack));
+            result += perimeter(node->fat_aabb);
             stack[stack_index++] = node->left;
             stack[stack_index++] = node->right;
         }
@@ -554,911 +706,4187 @@ ray_body_intersect_ ray_cast(phy_state_* state,
     return result;
 }
 
-ray_body_intersect_
-ray_cast_from_body(phy_state_* state,
-                   phy_body_* self,
-                   f32 width,
-                   v2 d,
-                   u32 required_flags) {
+inline v2
+get_centroid(phy_aabb_ aabb) {
+    return 0.5f * (aabb.min + aabb.max);
+}
 
-    phy_aabb_tree_* tree = &state->aabb_tree;
+inline i32
+get_build_bin(v2 centroid, i32 axis, f32 axis_min, f32 bin_scale) {
+    i32 bin = (i32)((centroid.e[axis] - axis_min) * bin_scale);
+    return iclamp(bin, 0, AABB_BUILD_BIN_COUNT - 1);
+}
 
-    ray_body_intersect_ result = {0};
-    i32 stack[MEDIUM_STACK_SIZE] = {0};
-    for (int i = 0; i < 2; ++i) {
-        v2 pd = perp(d);
-        v2 p = i ?
-            self->position + (0.5f * width * pd) :
-            self->position + (-0.5f * width * pd);
+// reorders indices so that the leaves on the left of the best binned sah
+// split come first, and returns how many of them there are
+i32
+aabb_partition_leaves(phy_aabb_tree_* tree, i32* indices, i32 count) {
+    v2 first = get_centroid(tree->nodes.at(indices[0])->fat_aabb);
+    phy_aabb_ centroid_bounds = phy_aabb_ {first, first};
+    for (i32 i = 1; i < count; ++i) {
+        v2 c = get_centroid(tree->nodes.at(indices[i])->fat_aabb);
+        centroid_bounds = get_union(centroid_bounds, phy_aabb_ {c, c});
+    }
 
-        i32 stack_index = 0;
-        stack[stack_index++] = tree->root;
+    v2 extent = centroid_bounds.max - centroid_bounds.min;
+    i32 axis = extent.x >= extent.y ? 0 : 1;
+    f32 axis_min = centroid_bounds.min.e[axis];
 
-        while (stack_index > 0) {
-            assert((size_t)stack_index < ARRAY_SIZE(stack));
-            phy_aabb_tree_node_* node = tree->nodes.at(stack[--stack_index]);
-            ray_intersect_ r = ray_aabb_intersect(p, d, node->fat_aabb);
-            if (!r.intersecting || (result.body && result.depth < r.depth)) {
-                continue;
-            }
+    if (extent.e[axis] <= 0.0f) {
+        // every centroid is in the same spot, so any split is as good as any
+        // other
+        return count / 2;
+    }
 
-            if (node->type == LEAF_NODE) {
-                phy_body_* body = node->body;
-                if (!body || body == self) { continue; }
-                if ((body->flags & required_flags) != required_flags) { continue; }
-                r = ray_body_intersect(p, d, body);
+    f32 bin_scale = (f32)AABB_BUILD_BIN_COUNT / extent.e[axis];
 
-                if (!r.intersecting || (result.body && result.depth < r.depth)) {
-                    continue;
-                }
+    i32 bin_counts[AABB_BUILD_BIN_COUNT] = {0};
+    phy_aabb_ bin_bounds[AABB_BUILD_BIN_COUNT];
+    for (i32 i = 0; i < count; ++i) {
+        phy_aabb_ aabb = tree->nodes.at(indices[i])->fat_aabb;
+        i32 bin = get_build_bin(get_centroid(aabb), axis, axis_min, bin_scale);
+        bin_bounds[bin] = bin_counts[bin] ? get_union(bin_bounds[bin], aabb)
+                                          : aabb;
+        bin_counts[bin]++;
+    }
 
-                result.body = body;
-                result.depth = r.depth;
-            } else {
-                stack[stack_index++] = node->left;
-                stack[stack_index++] = node->right;
-            }
+    // right_costs[i] is the cost of putting bins i and up on the right
+    f32 right_costs[AABB_BUILD_BIN_COUNT];
+    phy_aabb_ right_bounds = {};
+    i32 right_count = 0;
+    for (i32 i = AABB_BUILD_BIN_COUNT - 1; i > 0; --i) {
+        if (bin_counts[i]) {
+            right_bounds = right_count ? get_union(right_bounds, bin_bounds[i])
+                                       : bin_bounds[i];
+            right_count += bin_counts[i];
+        }
+        right_costs[i] = perimeter(right_bounds) * (f32)right_count;
+    }
+
+    i32 best_bin = -1;
+    f32 best_cost = FLT_MAX;
+    phy_aabb_ left_bounds = {};
+    i32 left_count = 0;
+    for (i32 i = 1; i < AABB_BUILD_BIN_COUNT; ++i) {
+        if (bin_counts[i - 1]) {
+            left_bounds = left_count ? get_union(left_bounds, bin_bounds[i - 1])
+                                     : bin_bounds[i - 1];
+            left_count += bin_counts[i - 1];
+        }
+        if (left_count == 0 || left_count == count) {
+            continue;
+        }
+
+        f32 cost = perimeter(left_bounds) * (f32)left_count + right_costs[i];
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_bin = i;
+        }
+    }
+
+    // the centroid bounds touch the first and last bins, so there's always
+    // at least one split with leaves on both sides
+    assert_(best_bin != -1);
+
+    i32 result = 0;
+    for (i32 i = 0; i < count; ++i) {
+        v2 c = get_centroid(tree->nodes.at(indices[i])->fat_aabb);
+        if (get_build_bin(c, axis, axis_min, bin_scale) < best_bin) {
+            i32 temp = indices[i];
+            indices[i] = indices[result];
+            indices[result++] = temp;
         }
     }
 
     return result;
 }
 
+// builds tree top down over the given leaves. the tree must not have any
+// internal nodes in use. internal_nodes is scratch space, which ends up
+// holding the internal nodes in the order they were made
 void
-find_broad_phase_collisions(phy_state_* state) {
+aabb_build_tree(phy_aabb_tree_* tree,
+                vec<i32>* leaves,
+                vec<i32>* internal_nodes) {
     TIMED_FUNC();
 
-    phy_aabb_tree_* tree = &state->aabb_tree;
-    state->potential_collisions.count = 0;
-    if (tree->nodes.count == 0) {
-        return;
-    }
-    phy_aabb_tree_node_* root = tree->nodes.at(tree->root);
-    if (root->type == LEAF_NODE) {
+    ++tree->version;
+    internal_nodes->count = 0;
+    tree->root = -1;
+    if (leaves->count == 0) {
+        tree->nodes.count = 0;
+        tree->dead_nodes.count = 0;
         return;
     }
-    for (int i = 0; i < tree->checked_parents.count; ++i) {
-        tree->checked_parents.values[i] = false;
-    }
-
-    i32 stack[MEDIUM_STACK_SIZE] = {0};
-    i32 stack_index = -1;
-    stack[++stack_index] = root->left;
-    stack[++stack_index] = root->right;
 
-    while (stack_index >= 0) {
-        assert_(stack_index % 2 == 1);
-        i32 a_index = stack[stack_index--];
-        i32 b_index = stack[stack_index--];
+    phy_build_range_ stack[MEDIUM_STACK_SIZE];
+    i32 stack_index = 0;
+    stack[stack_index++] = phy_build_range_ {0, leaves->count, -1, false};
 
-        phy_aabb_tree_node_ *a = tree->nodes.at(a_index);
-        phy_aabb_tree_node_ *b = tree->nodes.at(b_index);
+    while (stack_index > 0) {
+        phy_build_range_ range = stack[--stack_index];
+        i32* indices = leaves->at(range.start);
 
-        if (a->is_asleep && b->is_asleep) {
-            continue;
+        i32 index;
+        if (range.count == 1) {
+            index = indices[0];
+        } else {
+            index = aabb_allocate_node(tree);
+            internal_nodes->push(index);
+
+            i32 split = aabb_partition_leaves(tree, indices, range.count);
+
+            assert_(stack_index + 2 <= (i32)ARRAY_SIZE(stack));
+            stack[stack_index++] = phy_build_range_ {range.start + split,
+                                                     range.count - split,
+                                                     index,
+                                                     false};
+            stack[stack_index++] = phy_build_range_ {range.start,
+                                                     split,
+                                                     index,
+                                                     true};
         }
 
-        if (a->type == LEAF_NODE) {
-            if (b->type == LEAF_NODE) {
-                phy_body_* a_body = a->body;
-                phy_body_* b_body = b->body;
-                if (!is_freed(a_body) && !is_freed(b_body) &&
-                    (!(a_body->flags & PHY_FIXED_FLAG) ||
-                    !(b_body->flags & PHY_FIXED_FLAG))) {
-
-                    phy_aabb_ aabb_a = a_body->aabb;
-                    phy_aabb_ aabb_b = b_body->aabb;
-                    if (aabb_are_intersecting(aabb_a, aabb_b)) {
-                        phy_potential_collision_ collision;
-                        if (a->body < b->body) {
-                            collision.a = a->body;
-                            collision.b = b->body;
-                        } else {
-                            collision.a = b->body;
-                            collision.b = a->body;
-                        }
-                        state->potential_collisions.push(collision);
-                    }
-                }
-            } else {
-                if (!tree->checked_parents[b_index]) {
-                    tree->checked_parents.values[b_index] = true;
-                    stack[++stack_index] = b->left;
-                    stack[++stack_index] = b->right;
-                }
-
-                if (aabb_are_intersecting(a->fat_aabb, b->fat_aabb)) {
-                    stack[++stack_index] = a_index;
-                    stack[++stack_index] = b->left;
-                    stack[++stack_index] = a_index;
-                    stack[++stack_index] = b->right;
-                }
-            }
+        tree->nodes.at(index)->parent = range.parent;
+        if (range.parent == -1) {
+            tree->root = index;
+        } else if (range.is_left) {
+            tree->nodes.at(range.parent)->left = index;
         } else {
-            if (b->type == LEAF_NODE) {
-
-                if (!tree->checked_parents[a_index]) {
-                    tree->checked_parents.values[a_index] = true;
-                    stack[++stack_index] = a->left;
-                    stack[++stack_index] = a->right;
-                }
+            tree->nodes.at(range.parent)->right = index;
+        }
+    }
 
-                if (aabb_are_intersecting(a->fat_aabb, b->fat_aabb)) {
-                    stack[++stack_index] = b_index;
-                    stack[++stack_index] = a->left;
-                    stack[++stack_index] = b_index;
-                    stack[++stack_index] = a->right;
-                }
-            } else {
-                if (!tree->checked_parents[a_index]) {
-                    tree->checked_parents.values[a_index] = true;
-                    stack[++stack_index] = a->left;
-                    stack[++stack_index] = a->right;
-                }
-                if (!tree->checked_parents[b_index]) {
-                    tree->checked_parents.values[b_index] = true;
-                    stack[++stack_index] = b->left;
-                    stack[++stack_index] = b->right;
-                }
+    // children are always made after their parents, so walking backwards
+    // refits every node after both of its children
+    for (i32 i = internal_nodes->count - 1; i >= 0; --i) {
+        aabb_refit_node(tree, tree->nodes.at((*internal_nodes)[i]));
+    }
+}
 
-                if (aabb_are_intersecting(a->fat_aabb, b->fat_aabb)) {
+// adds every leaf linked into tree to leaves, frees all of the internal nodes
+// and builds the tree again from scratch
+void
+aabb_rebuild_tree(phy_aabb_tree_* tree,
+                  vec<i32>* leaves,
+                  vec<i32>* internal_nodes) {
+    TIMED_FUNC();
 
-                    stack[++stack_index] = b->left;
-                    stack[++stack_index] = a->left;
-                    stack[++stack_index] = b->right;
-                    stack[++stack_index] = a->right;
+    if (tree->root != -1) {
+        i32 stack[LARGE_STACK_SIZE];
+        i32 stack_index = 0;
+        stack[stack_index++] = tree->root;
 
-                    stack[++stack_index] = b->right;
-                    stack[++stack_index] = a->left;
-                    stack[++stack_index] = b->left;
-                    stack[++stack_index] = a->right;
-                }
+        while (stack_index > 0) {
+            i32 index = stack[--stack_index];
+            phy_aabb_tree_node_* node = tree->nodes.at(index);
+            if (node->type == LEAF_NODE) {
+                leaves->push(index);
+            } else {
+                assert_(stack_index + 2 <= (i32)ARRAY_SIZE(stack));
+                stack[stack_index++] = node->left;
+                stack[stack_index++] = node->right;
+                tree->dead_nodes.push(index);
             }
         }
     }
-}
 
-phy_body_*
-phy_add_block(phy_state_* state,
-              v2 center,
-              v2 diagonal,
-              f32 mass,
-              f32 orientation) {
+    aabb_build_tree(tree, leaves, internal_nodes);
+}
 
-    phy_body_* body = phy_add_body(state);
+inline i32
+encode_wide_leaf(i32 leaf_index) {
+    return -2 - leaf_index;
+}
 
-    f32 width = diagonal.x;
-    f32 height = diagonal.y;
+inline i32
+decode_wide_leaf(i32 child) {
+    return -2 - child;
+}
 
-    body->mass = mass;
-    body->gravity_normal = v2{0};
-    body->inv_mass = 1.0f / body->mass;
-    body->moment = 1.0f/12.0f * body->mass * (width * width + height * height);
-    body->inv_moment = 1.0f / body->moment;
-    body->hulls = phy_add_hulls(state, 1);
-    body->aabb_node_index = -1;
-    body->position = center;
-    body->orientation = orientation;
+// collapses the binary tree into a tree of 4 wide nodes. every wide node
+// starts with its binary node's two children and keeps opening up the
+// biggest internal one until it has four
+void
+aabb_build_wide_tree(phy_aabb_tree_* tree) {
+    TIMED_FUNC();
 
-    phy_hull_ * hull = body->hulls.values;
-    hull->mass = mass;
-    hull->inv_mass = 1.0f / hull->mass;
-    hull->moment = 1.0f;
-    hull->inv_moment = 1.0f/12.0f *
-            hull->mass *
-            (width * width + height * height);
+    phy_wide_tree_* wide = &tree->wide;
+    wide->nodes.count = 0;
+    wide->children.count = 0;
+    wide->version = tree->version;
 
-    hull->type = HULL_RECT;
-    hull->width = width;
-    hull->height = height;
+    if (tree->root == -1) {
+        return;
+    }
 
-    return body;
-}
+    // binary node, and the wide node it becomes
+    tuple2<i32, i32> stack[MEDIUM_STACK_SIZE];
+    i32 stack_index = 0;
+    stack[stack_index++] = tuple2<i32, i32> {tree->root,
+                                             wide->nodes.push_unassigned()};
+    wide->children.push_unassigned();
 
-phy_body_*
-phy_add_fillet_block(phy_state_* state,
-                     v2 center,
-                     v2 diagonal,
-                     f32 fillet, 
-                     f32 mass,
-                     f32 orientation) {
-    phy_body_* body = phy_add_body(state);
+    while (stack_index > 0) {
+        tuple2<i32, i32> entry = stack[--stack_index];
+        phy_aabb_tree_node_* node = tree->nodes.at(entry.first);
 
-    f32 width = diagonal.x;
-    f32 height = diagonal.y;
-    
-    body->mass = mass;
-    body->gravity_normal = v2{0};
-    body->inv_mass = 1.0f / body->mass;
-    body->moment = 1.0f/12.0f * body->mass * (width * width + height * height);
-    body->inv_moment = 1.0f / body->moment;
-    body->hulls = phy_add_hulls(state, 1);
-    body->aabb_node_index = -1;
-    body->position = center;
-    body->orientation = orientation;
+        i32 slots[4];
+        i32 slot_count = 0;
+        if (node->type == LEAF_NODE) {
+            slots[slot_count++] = entry.first;
+        } else {
+            slots[slot_count++] = node->left;
+            slots[slot_count++] = node->right;
+        }
 
-    phy_hull_ * hull = body->hulls.values;
-    hull->mass = mass;
-    hull->inv_mass = 1.0f / hull->mass;
-    hull->moment = 1.0f;
-    hull->inv_moment = 1.0f/12.0f *
-            hull->mass *
-            (width * width + height * height);
-    hull->type = HULL_FILLET_RECT;
-    hull->width = width;
-    hull->height = height;
-    hull->fillet = fillet;
+        while (slot_count < 4) {
+            i32 biggest = -1;
+            f32 biggest_perimeter = -1.0f;
+            for (i32 i = 0; i < slot_count; ++i) {
+                phy_aabb_tree_node_* slot = tree->nodes.at(slots[i]);
+                if (slot->type != LEAF_NODE &&
+                    perimeter(slot->fat_aabb) > biggest_perimeter) {
+                    biggest = i;
+                    biggest_perimeter = perimeter(slot->fat_aabb);
+                }
+            }
+            if (biggest == -1) {
+                break;
+            }
 
-    return body;
-}
+            phy_aabb_tree_node_* opened = tree->nodes.at(slots[biggest]);
+            slots[biggest] = opened->left;
+            slots[slot_count++] = opened->right;
+        }
 
-phy_body_*
-phy_add_body(phy_state_* state) {
-    return state->bodies.acquire();
-}
+        phy_wide_node_* wide_node = wide->nodes.at(entry.second);
+        phy_wide_children_* children = wide->children.at(entry.second);
+        for (i32 i = 0; i < 4; ++i) {
+            if (i >= slot_count) {
+                // empty slots can never overlap anything
+                wide_node->min_x[i] = FLT_MAX;
+                wide_node->min_y[i] = FLT_MAX;
+                wide_node->max_x[i] = -FLT_MAX;
+                wide_node->max_y[i] = -FLT_MAX;
+                children->index[i] = WIDE_EMPTY;
+                continue;
+            }
 
-void
-phy_remove_body(phy_state_* state, phy_body_* body) {
+            phy_aabb_tree_node_* slot = tree->nodes.at(slots[i]);
+            wide_node->min_x[i] = slot->fat_aabb.min.x;
+            wide_node->min_y[i] = slot->fat_aabb.min.y;
+            wide_node->max_x[i] = slot->fat_aabb.max.x;
+            wide_node->max_y[i] = slot->fat_aabb.max.y;
 
-    aabb_remove_node(&state->aabb_tree, body->aabb_node_index);
-    state->hulls.free_many(body->hulls.values, body->hulls.count);
-    state->bodies.free(body);
-}
+            if (slot->type == LEAF_NODE) {
+                children->index[i] = encode_wide_leaf(slots[i]);
+            } else {
+                i32 child_index = wide->nodes.push_unassigned();
+                wide->children.push_unassigned();
+                children->index[i] = child_index;
 
-array<phy_hull_>
-phy_add_hulls(phy_state_* state, i32 count) {
-    return state->hulls.acquire_many(count);
+                assert_(stack_index < (i32)ARRAY_SIZE(stack));
+                stack[stack_index++] = tuple2<i32, i32> {slots[i],
+                                                         child_index};
+            }
+        }
+    }
 }
 
-array<v2>
-phy_add_points(phy_state_* state, i32 count) {
-
-    return state->points.acquire_many(count);
+// the wide tree is only rebuilt when something has asked for it since the
+// binary tree last changed
+phy_wide_tree_*
+aabb_get_wide_tree(phy_aabb_tree_* tree) {
+    if (tree->wide.version != tree->version) {
+        aabb_build_wide_tree(tree);
+    }
+    return &tree->wide;
 }
 
-phy_collision_*
-phy_add_collision(phy_state_* state) {
-    assert_(state->collisions.count < state->collisions.capacity);
-    return state->collisions.values + state->collisions.count++;
+// returns a bit for every child of node whose bounds overlap aabb
+inline i32
+wide_overlap_mask(phy_wide_node_* node, phy_aabb_ aabb) {
+    __m128 min_x = _mm_load_ps(node->min_x);
+    __m128 min_y = _mm_load_ps(node->min_y);
+    __m128 max_x = _mm_load_ps(node->max_x);
+    __m128 max_y = _mm_load_ps(node->max_y);
+
+    __m128 x = _mm_and_ps(_mm_cmple_ps(min_x, _mm_set1_ps(aabb.max.x)),
+                          _mm_cmpge_ps(max_x, _mm_set1_ps(aabb.min.x)));
+    __m128 y = _mm_and_ps(_mm_cmple_ps(min_y, _mm_set1_ps(aabb.max.y)),
+                          _mm_cmpge_ps(max_y, _mm_set1_ps(aabb.min.y)));
+
+    return _mm_movemask_ps(_mm_and_ps(x, y));
 }
 
-phy_collision_*
-phy_add_collision(phy_state_* state, phy_collision_ collision) {
-    assert_(state->collisions.count < state->collisions.capacity);
-    phy_collision_* result =
-            state->collisions.values + state->collisions.count++;
-    *result = collision;
-    return result;
+// slab tests a ray against every child of node. writes the distance along
+// the ray to each child into depths, and returns a bit for every child that's
+// hit no further away than max_depth
+inline i32
+wide_ray_mask(phy_wide_node_* node,
+              v2 p,
+              v2 inv_d,
+              f32 max_depth,
+              f32* depths) {
+    __m128 px = _mm_set1_ps(p.x);
+    __m128 py = _mm_set1_ps(p.y);
+    __m128 inv_dx = _mm_set1_ps(inv_d.x);
+    __m128 inv_dy = _mm_set1_ps(inv_d.y);
+
+    __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node->min_x), px), inv_dx);
+    __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node->max_x), px), inv_dx);
+    __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node->min_y), py), inv_dy);
+    __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node->max_y), py), inv_dy);
+
+    __m128 t_min = _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y));
+    __m128 t_max = _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y));
+    t_min = _mm_max_ps(t_min, _mm_setzero_ps());
+
+    __m128 hit = _mm_and_ps(_mm_cmple_ps(t_min, t_max),
+                            _mm_cmple_ps(t_min, _mm_set1_ps(max_depth)));
+
+    _mm_storeu_ps(depths, t_min);
+    return _mm_movemask_ps(hit);
 }
 
-void
-update_hulls(phy_body_* body) {
+phy_aabb_
+get_aabb(phy_body_ *body) {
     TIMED_FUNC();
+
+    phy_aabb_ result;
+    result.min = v2 {FLT_MAX, FLT_MAX};
+    result.max = v2 {-FLT_MAX, -FLT_MAX};
     m2x2 rotation = get_rotation_matrix(body->orientation);
     for (int i = 0; i < body->hulls.count; ++i) {
-        phy_hull_* hull = body->hulls.at(i);
-        hull->position = body->position + rotation * hull->relative_position;
-        hull->orientation = body->orientation;
+        phy_hull_ *hull = body->hulls.at(i);
+
+        switch (hull->type) {
+            case HULL_MESH: {
+                for (int j = 0; j < hull->points.count; ++j) {
+                    v2 p = hull->position + rotation * hull->points[j];
+                    if (p.x < result.min.x) { result.min.x = p.x; }
+                    if (p.y < result.min.y) { result.min.y = p.y; }
+                    if (p.x > result.max.x) { result.max.x = p.x; }
+                    if (p.y > result.max.y) { result.max.y = p.y; }
+                }
+            } break;
+            default: {
+                result.min.x = do_support(hull, v2 {-1.0f, 0.0f}).x;
+                result.max.x = do_support(hull, v2 {1.0f, 0.0f}).x;
+                result.min.y = do_support(hull, v2 {0.0f, -1.0f}).y;
+                result.max.y = do_support(hull, v2 {0.0f, 1.0f}).y;
+            } break;
+        }
     }
+    return result;
 }
 
-v2
-do_simplex(phy_support_result_ support,
-           phy_support_result_* simplex,
-           i32* simplex_count) {
-    v2 result;
-    switch (*simplex_count) {
-        case 1: {
-            v2 ab = support.p - simplex[0].p;
-            simplex[1] = support;
-            *simplex_count += 1;
-            result = triple(ab, ab, simplex[0].p);
-        } break;
-        case 2: {
-            //        (support) c
-            //                 / \
-            //              o?/   \ o?
-            //               /  o? \
-            // (simplex[0]) a-------b (simplex[1])
+ray_intersect_
+ray_segment_intersect(v2 p, v2 d, v2 a, v2 b) {
+    v2 v_1 = p - a;
+    v2 v_2 = b - a;
+    v2 v_3 = perp(d);
+    f32 t_1 = flt_cross(v_2, v_1) / dot(v_2, v_3);
+    f32 t_2 = dot(v_1, v_3) / dot(v_2, v_3);
+    ray_intersect_ result;
+    result.intersecting = t_2 >= 0.0f && t_2 <= 1.0f && t_1 >= 0.0f;
 
-            v2 a = simplex[0].p;
-            v2 b = simplex[1].p;
-            v2 c = support.p;
+    result.depth = t_1;
+    return result;
+}
 
-            v2 ac = c - a;
-            // perpendicular away from b
-            v2 ac_p = triple(ac, ac, b);
-            f32 dot_acp = dot(ac_p, c);
-            if (dot_acp == 0.0f) {
-                // origin is on ac - return a collision and let EPA handle
-                // whether or not we care
-                *simplex_count += 1;
-                simplex[2] = support;
-                result = v2 {0};
-            } else if (dot_acp > 0.0f) {
-                // origin may be inside simplex - keep checking
-                v2 bc = c - b;
-                // perpendicular away from a
-                v2 bc_p = triple(bc, bc, a);
-                f32 dot_bcp = dot(bc_p, c);
-                if (dot_bcp >= 0.0f) {
-                    // origin is on bc or inside simplex
-                    *simplex_count += 1;
-                    simplex[2] = support;
-                    result = v2 {0};
-                } else {
-                    // origin is on outside of bc - replace a with c and check
-                    // perpendicular to bc away from c
-                    simplex[0] = support;
-                    result = bc_p;
+inline ray_intersect_
+ray_aabb_intersect(v2 p, v2 d, phy_aabb_ aabb) {
+    ray_intersect_ result;
+    result.intersecting = false;
+
+    if (aabb_is_contained_in(p, aabb)) {
+        result.intersecting = true;
+        result.depth = 0;
+    } else {
+        if (p.x <= aabb.min.x) {
+            f32 t = (aabb.min.x - p.x) / d.x;
+            f32 y = p.y + t * d.y;
+
+            if (t > 0.0f && y >= aabb.min.y && y <= aabb.max.y) {
+                result.intersecting = true;
+                result.depth = t;
+            }
+        } else if(!result.intersecting && p.x >= aabb.max.x) {
+            f32 t = (aabb.max.x - p.x) / d.x;
+            f32 y = p.y + t * d.y;
+
+            if (t > 0.0f && y >= aabb.min.y && y <= aabb.max.y) {
+                result.intersecting = true;
+                result.depth = t;
+            }
+        }
+
+        if(!result.intersecting && p.y <= aabb.min.y) {
+            f32 t = (aabb.min.y - p.y) / d.y;
+            f32 x = p.x + t * d.x;
+
+            if (t > 0.0f && x >= aabb.min.x && x <= aabb.max.x) {
+                result.intersecting = true;
+                result.depth = t;
+            }
+        } else if (!result.intersecting && p.y >= aabb.max.y) {
+            f32 t = (aabb.max.y - p.y) / d.y;
+            f32 x = p.x + t * d.x;
+
+            if (t > 0.0f && x >= aabb.min.x && x <= aabb.max.x) {
+                result.intersecting = true;
+                result.depth = t;
+            }
+        }
+    }
+    return result;
+}
+
+inline ray_intersect_
+ray_body_intersect(v2 p, v2 d, phy_body_* body) {
+    ray_intersect_ result;
+    result.intersecting = false;
+    for (int i = 0; i < body->hulls.count; ++i) {
+        ray_intersect_ r = ray_hull_intersect(p,d,body->hulls.at(i));
+
+        if (!r.intersecting || (result.intersecting && result.depth < r.depth)) { continue; }
+
+        result = r;
+    }
+    return result;
+}
+
+b32 hull_contains_point(phy_hull_* hull, v2 p) {
+    switch (hull->type) {
+        case HULL_MESH: {
+            assert_(false);
+        } break;
+        case HULL_RECT: {
+            v2 p_local = rotate(p - hull->position, -hull->orientation);
+            f32 width = hull->width;
+            f32 height = hull->height;
+            if (p_local.x >= -width / 2.0f && p_local.x <= width / 2.0f &&
+                p_local.y >= -height / 2.0f && p_local.y <= height / 2.0f) {
+                return true;
+            }
+        } break;
+        case HULL_FILLET_RECT: {
+
+            // TODO(doug): ignoring the fillet for now. will come back to it later
+            v2 p_local = rotate(p - hull->position, -hull->orientation);
+            f32 width = hull->width;
+            f32 height = hull->height;
+            if (p_local.x >= -width / 2.0f && p_local.x <= width / 2.0f &&
+                p_local.y >= -height / 2.0f && p_local.y <= height / 2.0f) {
+                return true;
+            }
+        } break;
+    }
+    return false;
+}
+
+b32 body_contains_point(phy_body_* body, v2 p) {
+    for (int i = 0; i < body->hulls.count; ++i) {
+        if (hull_contains_point(body->hulls.at(i), p)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline phy_aabb_tree_*
+get_tree(phy_state_* state, phy_body_* body) {
+    return (body->flags & PHY_FIXED_FLAG) ? &state->static_tree
+                                          : &state->dynamic_tree;
+}
+
+inline phy_aabb_
+get_fat_aabb(phy_state_* state, phy_body_* body) {
+    return get_tree(state, body)->nodes.at(body->aabb_node_index)->fat_aabb;
+}
+
+phy_body_* pick_body(phy_aabb_tree_* tree, v2 p) {
+    phy_body_* result = 0;
+
+    phy_wide_tree_* wide = aabb_get_wide_tree(tree);
+    if (wide->nodes.count == 0) {
+        return result;
+    }
+
+    phy_aabb_ point = phy_aabb_ {p, p};
+
+    i32 stack[MEDIUM_STACK_SIZE] = {0};
+
+    i32 stack_index = 0;
+    stack[stack_index++] = 0;
+
+    while (stack_index > 0 && !result) {
+        i32 index = stack[--stack_index];
+        i32 mask = wide_overlap_mask(wide->nodes.at(index), point);
+        phy_wide_children_* children = wide->children.at(index);
+
+        for (i32 i = 0; i < 4; ++i) {
+            i32 child = children->index[i];
+            if (!(mask & (1 << i)) || child == WIDE_EMPTY) {
+                continue;
+            }
+
+            if (child < 0) {
+                phy_body_* body = tree->nodes.at(decode_wide_leaf(child))->body;
+                if (body_contains_point(body, p)) {
+                    result = body;
+                    break;
                 }
             } else {
-                // origin is on outside of ac - replace b with c and check
-                // perpendicular to ac away from b
-                simplex[1] = support;
-                result = ac_p;
+                assert_(stack_index < (i32)ARRAY_SIZE(stack));
+                stack[stack_index++] = child;
             }
-        } break;
-        default: assert_(false);
+        }
+    }
+
+    return result;
+}
+
+phy_body_* pick_body(phy_state_* state, v2 p) {
+    phy_body_* result = pick_body(&state->dynamic_tree, p);
+    if (!result) {
+        result = pick_body(&state->static_tree, p);
+    }
+    return result;
+}
+
+// casts against a single tree, only accepting hits closer than the one
+// already stored in result
+void ray_cast(phy_aabb_tree_* tree,
+              v2 p,
+              v2 d,
+              u32 required_flags,
+              phy_body_* exclude,
+              ray_body_intersect_* result) {
+    phy_wide_tree_* wide = aabb_get_wide_tree(tree);
+    if (wide->nodes.count == 0) {
+        return;
+    }
+
+    // a zero component would make the slab test divide by zero, but a huge
+    // one works out the same
+    v2 inv_d = v2 {
+        d.x != 0.0f ? 1.0f / d.x : FLT_MAX,
+        d.y != 0.0f ? 1.0f / d.y : FLT_MAX
+    };
+
+    // the second value is the distance to the node, so nodes behind the
+    // current best hit can be skipped once it's found
+    tuple2<i32, f32> stack[MEDIUM_STACK_SIZE];
+
+    i32 stack_index = 0;
+    stack[stack_index++] = tuple2<i32, f32> {0, 0.0f};
+
+    while (stack_index > 0) {
+        tuple2<i32, f32> entry = stack[--stack_index];
+        if (result->body && result->depth < entry.second) {
+            continue;
+        }
+
+        f32 max_depth = result->body ? result->depth : FLT_MAX;
+        f32 depths[4];
+        i32 mask = wide_ray_mask(wide->nodes.at(entry.first),
+                                 p,
+                                 inv_d,
+                                 max_depth,
+                                 depths);
+        phy_wide_children_* children = wide->children.at(entry.first);
+
+        // internal children get pushed farthest first, so the nearest one
+        // is visited next
+        tuple2<i32, f32> hits[4];
+        i32 hit_count = 0;
+
+        for (i32 i = 0; i < 4; ++i) {
+            i32 child = children->index[i];
+            if (!(mask & (1 << i)) || child == WIDE_EMPTY) {
+                continue;
+            }
+
+            if (child >= 0) {
+                i32 j = hit_count++;
+                for (; j > 0 && hits[j - 1].second < depths[i]; --j) {
+                    hits[j] = hits[j - 1];
+                }
+                hits[j] = tuple2<i32, f32> {child, depths[i]};
+                continue;
+            }
+
+            phy_body_* body = tree->nodes.at(decode_wide_leaf(child))->body;
+            if (!body || body == exclude) { continue; }
+            if ((body->flags & required_flags) != required_flags) { continue; }
+
+            // tilemaps answer ray casts by marching their grid instead
+            if (body->flags & PHY_TILEMAP_FLAG) { continue; }
+
+            ray_intersect_ r = ray_body_intersect(p, d, body);
+
+            if (!r.intersecting || (result->body && result->depth < r.depth)) {
+                continue;
+            }
+
+            result->body = body;
+            result->depth = r.depth;
+        }
+
+        assert_(stack_index + hit_count <= (i32)ARRAY_SIZE(stack));
+        for (i32 i = 0; i < hit_count; ++i) {
+            stack[stack_index++] = hits[i];
+        }
+    }
+}
+
+// marches the ray through the grid one cell at a time until it reaches a
+// solid one. like the per tile bodies this replaces, the hit is wherever the
+// ray first crosses the edge of a solid cell
+void
+ray_cast(phy_tilemap_* tilemap,
+         v2 p,
+         v2 d,
+         u32 required_flags,
+         phy_body_* exclude,
+         ray_body_intersect_* result) {
+    u32 flags = tilemap->flags | PHY_FIXED_FLAG | PHY_TILEMAP_FLAG;
+    if ((flags & required_flags) != required_flags) {
+        return;
+    }
+
+    // work in cell units. t stays in units of d
+    f32 inv_tile_size = 1.0f / tilemap->tile_size;
+    v2 local_p = inv_tile_size * (p - tilemap->origin);
+    v2 local_d = inv_tile_size * d;
+
+    // clip the ray to the grid
+    f32 t_enter = 0.0f;
+    f32 t_exit = FLT_MAX;
+    v2 grid_max = v2 {(f32)tilemap->width, (f32)tilemap->height};
+    for (i32 i = 0; i < 2; ++i) {
+        if (local_d.e[i] == 0.0f) {
+            if (local_p.e[i] < 0.0f || local_p.e[i] > grid_max.e[i]) {
+                return;
+            }
+            continue;
+        }
+
+        f32 t_1 = -local_p.e[i] / local_d.e[i];
+        f32 t_2 = (grid_max.e[i] - local_p.e[i]) / local_d.e[i];
+        t_enter = f32max(t_enter, f32min(t_1, t_2));
+        t_exit = f32min(t_exit, f32max(t_1, t_2));
+    }
+    if (t_enter > t_exit) {
+        return;
+    }
+
+    v2 start = local_p + t_enter * local_d;
+    i32 cell[2] = {
+        iclamp((i32)floorf(start.x), 0, tilemap->width - 1),
+        iclamp((i32)floorf(start.y), 0, tilemap->height - 1)
+    };
+    i32 cell_count[2] = {tilemap->width, tilemap->height};
+
+    i32 step[2];
+    f32 t_next[2];  // where the ray crosses into the next cell on each axis
+    f32 t_delta[2];
+    for (i32 i = 0; i < 2; ++i) {
+        if (local_d.e[i] > 0.0f) {
+            step[i] = 1;
+            t_next[i] = ((f32)(cell[i] + 1) - local_p.e[i]) / local_d.e[i];
+            t_delta[i] = 1.0f / local_d.e[i];
+        } else if (local_d.e[i] < 0.0f) {
+            step[i] = -1;
+            t_next[i] = ((f32)cell[i] - local_p.e[i]) / local_d.e[i];
+            t_delta[i] = -1.0f / local_d.e[i];
+        } else {
+            step[i] = 0;
+            t_next[i] = FLT_MAX;
+            t_delta[i] = FLT_MAX;
+        }
+    }
+
+    // starting inside a solid cell, the ray hits it on the way out
+    f32 t = t_enter;
+    b32 inside = t_enter == 0.0f;
+
+    for (;;) {
+        if (result->body && result->depth < t) {
+            return;
+        }
+
+        i32 index = cell[1] * tilemap->width + cell[0];
+        phy_body_* body = tilemap->cell_bodies[index];
+        if (body && body != exclude) {
+            result->body = body;
+            result->depth = inside ? f32min(t_next[0], t_next[1]) : t;
+            return;
+        }
+
+        inside = false;
+        i32 axis = t_next[0] < t_next[1] ? 0 : 1;
+        t = t_next[axis];
+        if (t > t_exit) {
+            return;
+        }
+
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= cell_count[axis]) {
+            return;
+        }
+        t_next[axis] += t_delta[axis];
+    }
+}
+
+void
+ray_cast_tilemaps(phy_state_* state,
+                  v2 p,
+                  v2 d,
+                  u32 required_flags,
+                  phy_body_* exclude,
+                  ray_body_intersect_* result) {
+    for (i32 i = 0; i < state->tilemaps.count; ++i) {
+        ray_cast(state->tilemaps[i], p, d, required_flags, exclude, result);
+    }
+}
+
+// slab tests every ray of a packet against one box at once. returns a bit for
+// every ray that hits it no further away than that ray's current best hit, and
+// writes the distance along each ray into depths
+inline i32
+packet_ray_mask(phy_ray_packet_* packet,
+                f32 min_x,
+                f32 min_y,
+                f32 max_x,
+                f32 max_y,
+                f32* depths) {
+    __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min_x), packet->p_x), packet->inv_d_x);
+    __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max_x), packet->p_x), packet->inv_d_x);
+    __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min_y), packet->p_y), packet->inv_d_y);
+    __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max_y), packet->p_y), packet->inv_d_y);
+
+    __m128 t_min = _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y));
+    __m128 t_max = _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y));
+    t_min = _mm_max_ps(t_min, _mm_setzero_ps());
+
+    __m128 hit = _mm_and_ps(_mm_cmple_ps(t_min, t_max),
+                            _mm_cmple_ps(t_min, _mm_load_ps(packet->max_depth)));
+
+    _mm_storeu_ps(depths, t_min);
+    return _mm_movemask_ps(hit);
+}
+
+// walks a tree once for up to four rays. a node is only entered by the rays
+// that hit it, and the leaves are tested per ray
+void
+ray_cast_packet(phy_aabb_tree_* tree,
+                phy_ray_* rays,
+                i32 count,
+                ray_body_intersect_* results) {
+    phy_wide_tree_* wide = aabb_get_wide_tree(tree);
+    if (wide->nodes.count == 0) {
+        return;
+    }
+
+    // unused lanes get a negative max depth, so they never hit anything
+    phy_ray_packet_ packet;
+    f32 p_x[4], p_y[4], inv_d_x[4], inv_d_y[4];
+    for (i32 i = 0; i < 4; ++i) {
+        if (i < count) {
+            p_x[i] = rays[i].p.x;
+            p_y[i] = rays[i].p.y;
+            inv_d_x[i] = rays[i].d.x != 0.0f ? 1.0f / rays[i].d.x : FLT_MAX;
+            inv_d_y[i] = rays[i].d.y != 0.0f ? 1.0f / rays[i].d.y : FLT_MAX;
+            packet.max_depth[i] = results[i].body ? results[i].depth : FLT_MAX;
+        } else {
+            p_x[i] = p_y[i] = 0.0f;
+            inv_d_x[i] = inv_d_y[i] = 1.0f;
+            packet.max_depth[i] = -1.0f;
+        }
+    }
+    packet.p_x = _mm_loadu_ps(p_x);
+    packet.p_y = _mm_loadu_ps(p_y);
+    packet.inv_d_x = _mm_loadu_ps(inv_d_x);
+    packet.inv_d_y = _mm_loadu_ps(inv_d_y);
+
+    // the second value is the mask of rays still interested in the node
+    tuple2<i32, i32> stack[MEDIUM_STACK_SIZE];
+
+    i32 stack_index = 0;
+    stack[stack_index++] = tuple2<i32, i32> {0, (1 << count) - 1};
+
+    while (stack_index > 0) {
+        tuple2<i32, i32> entry = stack[--stack_index];
+        phy_wide_node_* node = wide->nodes.at(entry.first);
+        phy_wide_children_* children = wide->children.at(entry.first);
+
+        // internal children get pushed farthest first, so the one nearest
+        // to any of the rays is visited next
+        tuple2<i32, i32> hits[4];
+        f32 hit_depths[4];
+        i32 hit_count = 0;
+
+        for (i32 i = 0; i < 4; ++i) {
+            i32 child = children->index[i];
+            if (child == WIDE_EMPTY) {
+                continue;
+            }
+
+            f32 depths[4];
+            i32 mask = entry.second & packet_ray_mask(&packet,
+                                                      node->min_x[i],
+                                                      node->min_y[i],
+                                                      node->max_x[i],
+                                                      node->max_y[i],
+                                                      depths);
+            if (!mask) {
+                continue;
+            }
+
+            if (child >= 0) {
+                f32 depth = FLT_MAX;
+                for (i32 r = 0; r < count; ++r) {
+                    if (mask & (1 << r)) { depth = f32min(depth, depths[r]); }
+                }
+
+                i32 j = hit_count++;
+                for (; j > 0 && hit_depths[j - 1] < depth; --j) {
+                    hits[j] = hits[j - 1];
+                    hit_depths[j] = hit_depths[j - 1];
+                }
+                hits[j] = tuple2<i32, i32> {child, mask};
+                hit_depths[j] = depth;
+                continue;
+            }
+
+            phy_body_* body = tree->nodes.at(decode_wide_leaf(child))->body;
+            if (!body || (body->flags & PHY_TILEMAP_FLAG)) {
+                continue;
+            }
+
+            for (i32 r = 0; r < count; ++r) {
+                if (!(mask & (1 << r)) || body == rays[r].exclude) {
+                    continue;
+                }
+                u32 required_flags = rays[r].required_flags;
+                if ((body->flags & required_flags) != required_flags) {
+                    continue;
+                }
+
+                ray_intersect_ hit = ray_body_intersect(rays[r].p, rays[r].d, body);
+                if (!hit.intersecting || hit.depth > packet.max_depth[r]) {
+                    continue;
+                }
+
+                results[r].body = body;
+                results[r].depth = hit.depth;
+                packet.max_depth[r] = hit.depth;
+            }
+        }
+
+        assert_(stack_index + hit_count <= (i32)ARRAY_SIZE(stack));
+        for (i32 i = 0; i < hit_count; ++i) {
+            stack[stack_index++] = hits[i];
+        }
+    }
+}
+
+// casts many rays with one walk of each tree per packet of four. rays next to
+// each other in the array should point roughly the same way from roughly the
+// same place, or the packets don't save much
+void
+ray_cast_batch(phy_state_* state,
+               phy_ray_* rays,
+               i32 count,
+               ray_body_intersect_* results) {
+    TIMED_FUNC();
+
+    ZERO_ARRAY(results, count);
+    for (i32 i = 0; i < count; i += 4) {
+        i32 packet_count = i32min(4, count - i);
+        ray_cast_packet(&state->dynamic_tree, rays + i, packet_count, results + i);
+        ray_cast_packet(&state->static_tree, rays + i, packet_count, results + i);
+    }
+
+    for (i32 i = 0; i < count; ++i) {
+        ray_cast_tilemaps(state,
+                          rays[i].p,
+                          rays[i].d,
+                          rays[i].required_flags,
+                          rays[i].exclude,
+                          results + i);
+    }
+}
+
+ray_body_intersect_ ray_cast(phy_state_* state,
+                              v2 p,
+                              v2 d,
+                              u32 required_flags,
+                              phy_body_* exclude) {
+    ray_body_intersect_ result = {0};
+    ray_cast(&state->dynamic_tree, p, d, required_flags, exclude, &result);
+    ray_cast(&state->static_tree, p, d, required_flags, exclude, &result);
+    ray_cast_tilemaps(state, p, d, required_flags, exclude, &result);
+    return result;
+}
+
+ray_body_intersect_
+ray_cast_from_body(phy_state_* state,
+                   phy_body_* self,
+                   f32 width,
+                   v2 d,
+                   u32 required_flags) {
+
+    // one ray from each side of the body, cast together
+    phy_ray_ rays[2];
+    for (int i = 0; i < 2; ++i) {
+        v2 pd = perp(d);
+        rays[i].p = i ?
+            self->position + (0.5f * width * pd) :
+            self->position + (-0.5f * width * pd);
+        rays[i].d = d;
+        rays[i].required_flags = required_flags;
+        rays[i].exclude = self;
+    }
+
+    ray_body_intersect_ results[2];
+    ray_cast_batch(state, rays, 2, results);
+
+    if (!results[0].body ||
+        (results[1].body && results[1].depth < results[0].depth)) {
+        return results[1];
+    }
+    return results[0];
+}
+
+inline b32
+pair_less_than(phy_potential_collision_ lhs, phy_potential_collision_ rhs) {
+    if (lhs.a != rhs.a) {
+        return lhs.a < rhs.a;
+    }
+    return lhs.b < rhs.b;
+}
+
+void
+sort_pairs(phy_potential_collision_* pairs, i32 count) {
+    TIMED_FUNC();
+
+    // iterative quicksort, falling back to insertion sort for short ranges.
+    // the smaller partition is always processed first so the stack stays
+    // logarithmic in count
+    const i32 insertion_sort_threshold = 16;
+    const i32 max_stack_size = 64;
+    tuple2<i32,i32> stack[max_stack_size];
+    i32 si = 0;
+    stack[si++] = {0, count};
+
+    while (si) {
+        tuple2<i32,i32> range = stack[--si];
+        i32 first = range.first;
+        i32 last = range.second;
+
+        if (last - first <= insertion_sort_threshold) {
+            for (int i = first + 1; i < last; ++i) {
+                phy_potential_collision_ pair = pairs[i];
+                i32 j = i;
+                while (j > first && pair_less_than(pair, pairs[j - 1])) {
+                    pairs[j] = pairs[j - 1];
+                    --j;
+                }
+                pairs[j] = pair;
+            }
+            continue;
+        }
+
+        phy_potential_collision_ pivot = pairs[first + (last - first) / 2];
+        i32 left = first;
+        i32 right = last - 1;
+        while (left <= right) {
+            while (pair_less_than(pairs[left], pivot)) { ++left; }
+            while (pair_less_than(pivot, pairs[right])) { --right; }
+            if (left <= right) {
+                phy_potential_collision_ temp = pairs[left];
+                pairs[left] = pairs[right];
+                pairs[right] = temp;
+                ++left;
+                --right;
+            }
+        }
+
+        assert_(si + 2 <= max_stack_size);
+        if (right + 1 - first < last - left) {
+            stack[si++] = {left, last};
+            stack[si++] = {first, right + 1};
+        } else {
+            stack[si++] = {first, right + 1};
+            stack[si++] = {left, last};
+        }
+    }
+}
+
+inline void
+push_pair(vec<phy_potential_collision_>* pairs, phy_body_* a, phy_body_* b) {
+    phy_potential_collision_ pair;
+    if (a < b) {
+        pair.a = a;
+        pair.b = b;
+    } else {
+        pair.a = b;
+        pair.b = a;
+    }
+    pairs->push(pair);
+}
+
+// finds every proxy in tree whose fat aabb overlaps the moved body's fat aabb
+// and records the pair in new_pairs
+void
+query_moved_proxy(phy_state_* state, phy_aabb_tree_* tree, phy_body_* body) {
+    phy_wide_tree_* wide = aabb_get_wide_tree(tree);
+    if (wide->nodes.count == 0) {
+        return;
+    }
+
+    phy_aabb_ fat_aabb = get_fat_aabb(state, body);
+
+    i32 stack[MEDIUM_STACK_SIZE];
+    i32 stack_index = 0;
+    stack[stack_index++] = 0;
+
+    while (stack_index > 0) {
+        i32 index = stack[--stack_index];
+        i32 mask = wide_overlap_mask(wide->nodes.at(index), fat_aabb);
+        phy_wide_children_* children = wide->children.at(index);
+
+        for (i32 i = 0; i < 4; ++i) {
+            i32 child = children->index[i];
+            if (!(mask & (1 << i)) || child == WIDE_EMPTY) {
+                continue;
+            }
+
+            if (child >= 0) {
+                assert_(stack_index < (i32)ARRAY_SIZE(stack));
+                stack[stack_index++] = child;
+                continue;
+            }
+
+            phy_body_* other = tree->nodes.at(decode_wide_leaf(child))->body;
+            if (other == body) {
+                continue;
+            }
+
+            // when both proxies moved, the one with the lower address reports
+            // the pair so it isn't added twice
+            if (other->proxy_moved && other < body) {
+                continue;
+            }
+
+            push_pair(&state->new_pairs, body, other);
+        }
+    }
+}
+
+inline void
+mark_proxy_moved(phy_state_* state, phy_body_* body) {
+    if (!body->proxy_moved) {
+        body->proxy_moved = true;
+        state->move_buffer.push(body);
+    }
+}
+
+void
+remove_pairs_for_body(phy_state_* state, phy_body_* body) {
+    i32 count = 0;
+    for (int i = 0; i < state->pairs.count; ++i) {
+        phy_potential_collision_ pair = state->pairs[i];
+        if (pair.a != body && pair.b != body) {
+            state->pairs[count++] = pair;
+        }
+    }
+    state->pairs.count = count;
+
+    if (body->proxy_moved) {
+        for (int i = 0; i < state->move_buffer.count; ++i) {
+            if (state->move_buffer[i] == body) {
+                state->move_buffer[i] =
+                    state->move_buffer[--state->move_buffer.count];
+                break;
+            }
+        }
+        body->proxy_moved = false;
+    }
+}
+
+void
+update_pairs(phy_state_* state) {
+    TIMED_FUNC();
+
+    if (state->move_buffer.count == 0) {
+        return;
+    }
+
+    // dynamic proxies are checked against both trees, fixed proxies only
+    // need the dynamic tree since fixed-fixed pairs never collide
+    state->new_pairs.count = 0;
+    for (int i = 0; i < state->move_buffer.count; ++i) {
+        phy_body_* body = state->move_buffer[i];
+        query_moved_proxy(state, &state->dynamic_tree, body);
+        if (!(body->flags & PHY_FIXED_FLAG)) {
+            query_moved_proxy(state, &state->static_tree, body);
+        }
+    }
+
+    sort_pairs(state->new_pairs.values, state->new_pairs.count);
+
+    // merge the old pairs with the new ones. every pair touching a moved
+    // proxy was just re-found by its query, so the old copies are dropped
+    vec<phy_potential_collision_>* old_pairs = &state->pairs;
+    vec<phy_potential_collision_>* new_pairs = &state->new_pairs;
+    vec<phy_potential_collision_>* merged = &state->pair_scratch;
+    merged->count = 0;
+
+    i32 i = 0;
+    i32 j = 0;
+    while (i < old_pairs->count || j < new_pairs->count) {
+        if (i < old_pairs->count) {
+            phy_potential_collision_ old_pair = (*old_pairs)[i];
+            if (old_pair.a->proxy_moved || old_pair.b->proxy_moved) {
+                ++i;
+                continue;
+            }
+        }
+
+        if (j == new_pairs->count ||
+            (i < old_pairs->count && pair_less_than((*old_pairs)[i], (*new_pairs)[j]))) {
+            merged->push((*old_pairs)[i++]);
+        } else {
+            merged->push((*new_pairs)[j++]);
+        }
+    }
+
+    vec<phy_potential_collision_> temp = state->pairs;
+    state->pairs = state->pair_scratch;
+    state->pair_scratch = temp;
+
+    for (int k = 0; k < state->move_buffer.count; ++k) {
+        state->move_buffer[k]->proxy_moved = false;
+    }
+    state->move_buffer.count = 0;
+}
+
+// pairs where neither body can move don't need the narrow phase. a body is
+// only in dynamic_bodies while it's awake
+inline b32
+pair_is_awake(phy_potential_collision_ pair) {
+    return pair.a->dynamic_index != -1 || pair.b->dynamic_index != -1;
+}
+
+void
+find_tree_collisions(phy_state_* state) {
+    TIMED_FUNC();
+
+    update_pairs(state);
+
+    for (int i = 0; i < state->pairs.count; ++i) {
+        phy_potential_collision_ pair = state->pairs[i];
+        if (pair_is_awake(pair) &&
+            aabb_are_intersecting(pair.a->aabb, pair.b->aabb)) {
+            state->potential_collisions.push(pair);
+        }
+    }
+}
+
+void
+sap_init_intervals(phy_sap_intervals_* intervals,
+                   memory_arena_* memory,
+                   i32 capacity) {
+    // room for a lane's worth of sentinels past the end, so the sweep can
+    // always load four at a time
+    i32 padded = capacity + 4;
+    intervals->min_x = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    intervals->max_x = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    intervals->min_y = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    intervals->max_y = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    intervals->bodies = PUSH_ARRAY(memory, padded, phy_body_*);
+    intervals->count = 0;
+    intervals->capacity = capacity;
+    intervals->unsorted = false;
+    intervals->max_width = 0.0f;
+}
+
+inline phy_sap_intervals_*
+get_sap_intervals(phy_state_* state, phy_body_* body) {
+    return (body->flags & PHY_FIXED_FLAG) ? &state->sap.static_intervals
+                                          : &state->sap.dynamic_intervals;
+}
+
+void
+sap_add(phy_state_* state, phy_body_* body) {
+    phy_sap_intervals_* intervals = get_sap_intervals(state, body);
+    assert_(intervals->count < intervals->capacity);
+    intervals->bodies[intervals->count++] = body;
+    intervals->unsorted = true;
+}
+
+void
+sap_remove(phy_state_* state, phy_body_* body) {
+    phy_sap_intervals_* intervals = get_sap_intervals(state, body);
+
+    // shifting everything down keeps the rest in order
+    i32 count = 0;
+    for (i32 i = 0; i < intervals->count; ++i) {
+        if (intervals->bodies[i] != body) {
+            intervals->min_x[count] = intervals->min_x[i];
+            intervals->max_x[count] = intervals->max_x[i];
+            intervals->min_y[count] = intervals->min_y[i];
+            intervals->max_y[count] = intervals->max_y[i];
+            intervals->bodies[count] = intervals->bodies[i];
+            ++count;
+        }
+    }
+    intervals->count = count;
+
+    // the old last slot is past the end now, and the sentinels need
+    // writing again over it
+    intervals->unsorted = true;
+}
+
+void
+sap_refresh_bounds(phy_sap_intervals_* intervals) {
+    intervals->max_width = 0.0f;
+    for (i32 i = 0; i < intervals->count; ++i) {
+        phy_aabb_ aabb = intervals->bodies[i]->aabb;
+        intervals->min_x[i] = aabb.min.x;
+        intervals->max_x[i] = aabb.max.x;
+        intervals->min_y[i] = aabb.min.y;
+        intervals->max_y[i] = aabb.max.y;
+        intervals->max_width = f32max(intervals->max_width,
+                                      aabb.max.x - aabb.min.x);
+    }
+
+    for (i32 i = intervals->count; i < intervals->count + 4; ++i) {
+        intervals->min_x[i] = FLT_MAX;
+        intervals->max_x[i] = -FLT_MAX;
+        intervals->min_y[i] = FLT_MAX;
+        intervals->max_y[i] = -FLT_MAX;
+        intervals->bodies[i] = 0;
+    }
+}
+
+// sorts by min_x. bodies don't move far between steps, so a single insertion
+// sort pass is close to linear most of the time. freshly added intervals get
+// a shell sort first
+void
+sap_sort(phy_sap_intervals_* intervals) {
+    TIMED_FUNC();
+
+    const i32 gaps[] = {701, 301, 132, 57, 23, 10, 4, 1};
+    u32 first_gap = intervals->unsorted ? 0 : ARRAY_SIZE(gaps) - 1;
+
+    for (u32 g = first_gap; g < ARRAY_SIZE(gaps); ++g) {
+        i32 gap = gaps[g];
+        for (i32 i = gap; i < intervals->count; ++i) {
+            f32 min_x = intervals->min_x[i];
+            f32 max_x = intervals->max_x[i];
+            f32 min_y = intervals->min_y[i];
+            f32 max_y = intervals->max_y[i];
+            phy_body_* body = intervals->bodies[i];
+
+            i32 j = i;
+            for (; j >= gap && intervals->min_x[j - gap] > min_x; j -= gap) {
+                intervals->min_x[j] = intervals->min_x[j - gap];
+                intervals->max_x[j] = intervals->max_x[j - gap];
+                intervals->min_y[j] = intervals->min_y[j - gap];
+                intervals->max_y[j] = intervals->max_y[j - gap];
+                intervals->bodies[j] = intervals->bodies[j - gap];
+            }
+
+            intervals->min_x[j] = min_x;
+            intervals->max_x[j] = max_x;
+            intervals->min_y[j] = min_y;
+            intervals->max_y[j] = max_y;
+            intervals->bodies[j] = body;
+        }
+    }
+
+    intervals->unsorted = false;
+}
+
+// tests the interval min_x..max_x, min_y..max_y against the sorted intervals
+// starting at first, four at a time, until they start past max_x
+void
+sap_sweep(phy_state_* state,
+          phy_sap_intervals_* intervals,
+          i32 first,
+          phy_body_* body,
+          phy_aabb_ aabb) {
+    __m128 min_x = _mm_set1_ps(aabb.min.x);
+    __m128 max_x = _mm_set1_ps(aabb.max.x);
+    __m128 min_y = _mm_set1_ps(aabb.min.y);
+    __m128 max_y = _mm_set1_ps(aabb.max.y);
+
+    for (i32 i = first; i < intervals->count; i += 4) {
+        __m128 starts_before = _mm_cmple_ps(_mm_loadu_ps(intervals->min_x + i),
+                                            max_x);
+        if (!_mm_movemask_ps(starts_before)) {
+            break;
+        }
+
+        __m128 x = _mm_and_ps(starts_before,
+                              _mm_cmpge_ps(_mm_loadu_ps(intervals->max_x + i),
+                                           min_x));
+        __m128 y = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(intervals->min_y + i),
+                                           max_y),
+                              _mm_cmpge_ps(_mm_loadu_ps(intervals->max_y + i),
+                                           min_y));
+
+        // never trust the lanes past the end, sentinels or not
+        i32 mask = _mm_movemask_ps(_mm_and_ps(x, y));
+        if (intervals->count - i < 4) {
+            mask &= (1 << (intervals->count - i)) - 1;
+        }
+        for (i32 j = 0; mask; ++j, mask >>= 1) {
+            if (mask & 1) {
+                push_pair(&state->new_pairs, body, intervals->bodies[i + j]);
+            }
+        }
+    }
+}
+
+void
+find_sap_collisions(phy_state_* state) {
+    TIMED_FUNC();
+
+    // the trees still fill the move buffer, but sweep and prune doesn't need
+    // it
+    for (int i = 0; i < state->move_buffer.count; ++i) {
+        state->move_buffer[i]->proxy_moved = false;
+    }
+    state->move_buffer.count = 0;
+
+    phy_sap_intervals_* dynamic_intervals = &state->sap.dynamic_intervals;
+    phy_sap_intervals_* static_intervals = &state->sap.static_intervals;
+
+    sap_refresh_bounds(dynamic_intervals);
+    sap_sort(dynamic_intervals);
+
+    if (static_intervals->unsorted) {
+        sap_refresh_bounds(static_intervals);
+        sap_sort(static_intervals);
+    }
+
+    // static intervals are at most max_width wide, so none that start
+    // before min_x - max_width can reach a dynamic one. the dynamic intervals
+    // come in order of min_x, so the first static one worth testing only
+    // ever moves forward
+    i32 first_static = 0;
+
+    state->new_pairs.count = 0;
+    for (i32 i = 0; i < dynamic_intervals->count; ++i) {
+        phy_body_* body = dynamic_intervals->bodies[i];
+        sap_sweep(state, dynamic_intervals, i + 1, body, body->aabb);
+
+        // a sleeping body can't start touching anything fixed
+        if (body->sleeping_index != -1) {
+            continue;
+        }
+
+        f32 start = body->aabb.min.x - static_intervals->max_width;
+        while (first_static < static_intervals->count &&
+               static_intervals->min_x[first_static] < start) {
+            ++first_static;
+        }
+        sap_sweep(state, static_intervals, first_static, body, body->aabb);
+    }
+
+    // same order the tree hands them out in
+    sort_pairs(state->new_pairs.values, state->new_pairs.count);
+    for (i32 i = 0; i < state->new_pairs.count; ++i) {
+        if (pair_is_awake(state->new_pairs[i])) {
+            state->potential_collisions.push(state->new_pairs[i]);
+        }
+    }
+}
+
+void
+find_broad_phase_collisions(phy_state_* state) {
+    TIMED_FUNC();
+
+    state->potential_collisions.count = 0;
+
+    u64 start = rdtsc();
+    switch (state->broad_phase) {
+        case PHY_BROAD_PHASE_TREE: {
+            find_tree_collisions(state);
+        } break;
+        case PHY_BROAD_PHASE_SAP: {
+            find_sap_collisions(state);
+        } break;
+    }
+
+    if (!state->broad_phase_switched) {
+        phy_broad_phase_stats_* stats = &state->broad_phase_stats;
+        stats->cycles[state->broad_phase] += rdtsc() - start;
+        ++stats->steps[state->broad_phase];
+    }
+    state->broad_phase_switched = false;
+}
+
+void
+phy_wake_body(phy_state_* state, phy_body_* body) {
+    if (body->sleeping_index == -1) {
+        return;
+    }
+
+    phy_body_* island_body = body;
+    do {
+        phy_body_* next = island_body->island_next;
+
+        phy_body_* last = state->sleeping_bodies[--state->sleeping_bodies.count];
+        state->sleeping_bodies[island_body->sleeping_index] = last;
+        last->sleeping_index = island_body->sleeping_index;
+
+        island_body->sleeping_index = -1;
+        island_body->island_next = 0;
+        island_body->sleep_time = 0.0f;
+        island_body->dynamic_index = state->dynamic_bodies.count;
+        state->dynamic_bodies.push(island_body);
+
+        island_body = next;
+    } while (island_body != body);
+}
+
+// game code pokes at bodies directly, so anything asleep that was given a
+// velocity or a force since it went to sleep gets woken up
+void
+wake_disturbed_bodies(phy_state_* state) {
+    TIMED_FUNC();
+
+    // waking an island shuffles sleeping_bodies, so find them all first
+    state->wake_list.count = 0;
+    for (i32 i = 0; i < state->sleeping_bodies.count; ++i) {
+        phy_body_* body = state->sleeping_bodies[i];
+        if (body->velocity.x != 0.0f || body->velocity.y != 0.0f ||
+            body->angular_velocity != 0.0f ||
+            body->force.x != 0.0f || body->force.y != 0.0f ||
+            body->torque != 0.0f) {
+            state->wake_list.push(body);
+        }
+    }
+    for (i32 i = 0; i < state->wake_list.count; ++i) {
+        phy_wake_body(state, state->wake_list[i]);
+    }
+}
+
+void
+phy_wake_all_bodies(phy_state_* state) {
+    while (state->sleeping_bodies.count) {
+        phy_wake_body(state, state->sleeping_bodies[0]);
+    }
+}
+
+void
+phy_set_broad_phase(phy_state_* state, phy_broad_phase_ broad_phase) {
+    if (state->broad_phase == broad_phase) {
+        return;
+    }
+
+    state->broad_phase = broad_phase;
+    state->broad_phase_switched = true;
+
+    // the tree's pair set hasn't been kept up while sweep and prune was in
+    // use, so have every dynamic proxy find its pairs again
+    if (broad_phase == PHY_BROAD_PHASE_TREE) {
+        state->pairs.count = 0;
+        for (i32 i = 0; i < state->dynamic_bodies.count; ++i) {
+            mark_proxy_moved(state, state->dynamic_bodies[i]);
+        }
+        for (i32 i = 0; i < state->sleeping_bodies.count; ++i) {
+            mark_proxy_moved(state, state->sleeping_bodies[i]);
+        }
+    }
+}
+
+void
+phy_set_solver(phy_state_* state, phy_solver_ solver, f32 time_step) {
+    assert_(time_step > 0.0f);
+    state->solver = solver;
+    state->time_step = time_step;
+}
+
+phy_body_*
+phy_add_block(phy_state_* state,
+              v2 center,
+              v2 diagonal,
+              f32 mass,
+              f32 orientation) {
+
+    phy_body_* body = phy_add_body(state);
+
+    f32 width = diagonal.x;
+    f32 height = diagonal.y;
+
+    body->mass = mass;
+    body->gravity_normal = v2{0};
+    body->inv_mass = 1.0f / body->mass;
+    body->moment = 1.0f/12.0f * body->mass * (width * width + height * height);
+    body->inv_moment = 1.0f / body->moment;
+    body->hulls = phy_add_hulls(state, 1);
+    body->aabb_node_index = -1;
+    body->position = center;
+    body->orientation = orientation;
+
+    phy_hull_ * hull = body->hulls.values;
+    hull->mass = mass;
+    hull->inv_mass = 1.0f / hull->mass;
+    hull->moment = 1.0f;
+    hull->inv_moment = 1.0f/12.0f *
+            hull->mass *
+            (width * width + height * height);
+
+    hull->type = HULL_RECT;
+    hull->width = width;
+    hull->height = height;
+
+    return body;
+}
+
+phy_body_*
+phy_add_fillet_block(phy_state_* state,
+                     v2 center,
+                     v2 diagonal,
+                     f32 fillet, 
+                     f32 mass,
+                     f32 orientation) {
+    phy_body_* body = phy_add_body(state);
+
+    f32 width = diagonal.x;
+    f32 height = diagonal.y;
+    
+    body->mass = mass;
+    body->gravity_normal = v2{0};
+    body->inv_mass = 1.0f / body->mass;
+    body->moment = 1.0f/12.0f * body->mass * (width * width + height * height);
+    body->inv_moment = 1.0f / body->moment;
+    body->hulls = phy_add_hulls(state, 1);
+    body->aabb_node_index = -1;
+    body->position = center;
+    body->orientation = orientation;
+
+    phy_hull_ * hull = body->hulls.values;
+    hull->mass = mass;
+    hull->inv_mass = 1.0f / hull->mass;
+    hull->moment = 1.0f;
+    hull->inv_moment = 1.0f/12.0f *
+            hull->mass *
+            (width * width + height * height);
+    hull->type = HULL_FILLET_RECT;
+    hull->width = width;
+    hull->height = height;
+    hull->fillet = fillet;
+
+    return body;
+}
+
+phy_tilemap_*
+phy_add_tilemap(phy_state_* state,
+                memory_arena_* memory,
+                v2 origin,
+                i32 width,
+                i32 height,
+                f32 tile_size,
+                u32 flags) {
+    phy_tilemap_* tilemap = PUSH_STRUCT(memory, phy_tilemap_);
+    tilemap->origin = origin;
+    tilemap->tile_size = tile_size;
+    tilemap->width = width;
+    tilemap->height = height;
+    tilemap->flags = flags;
+    tilemap->entity.id = 0;
+
+    i32 cells = width * height;
+    tilemap->solid = PUSH_ARRAY(memory, cells, u8);
+    ZERO_ARRAY(tilemap->solid, cells);
+    tilemap->cell_bodies = PUSH_ARRAY(memory, cells, phy_body_*);
+    ZERO_ARRAY(tilemap->cell_bodies, cells);
+
+    // every cell could end up as its own body in a checkerboard
+    tilemap->bodies.init(memory, cells);
+
+    state->tilemaps.push(tilemap);
+    return tilemap;
+}
+
+void
+phy_set_tile(phy_tilemap_* tilemap, i32 x, i32 y, b32 solid) {
+    assert_(x >= 0 && x < tilemap->width);
+    assert_(y >= 0 && y < tilemap->height);
+    tilemap->solid[y * tilemap->width + x] = solid ? 1 : 0;
+}
+
+inline b32
+is_unmerged_tile(phy_tilemap_* tilemap, i32 x, i32 y) {
+    i32 index = y * tilemap->width + x;
+    return tilemap->solid[index] && !tilemap->cell_bodies[index];
+}
+
+// greedily merges the solid cells into rects - each one takes the longest run
+// it can along its row, then as many rows above as are solid all the way
+// across. each rect becomes one fixed body
+void
+phy_build_tilemap(phy_state_* state, phy_tilemap_* tilemap) {
+    TIMED_FUNC();
+
+    for (i32 i = 0; i < tilemap->bodies.count; ++i) {
+        phy_remove_body(state, tilemap->bodies[i]);
+    }
+    tilemap->bodies.count = 0;
+    i32 cells = tilemap->width * tilemap->height;
+    ZERO_ARRAY(tilemap->cell_bodies, cells);
+
+    for (i32 y = 0; y < tilemap->height; ++y) {
+        for (i32 x = 0; x < tilemap->width; ++x) {
+            if (!is_unmerged_tile(tilemap, x, y)) {
+                continue;
+            }
+
+            i32 run = 1;
+            while (x + run < tilemap->width &&
+                   is_unmerged_tile(tilemap, x + run, y)) {
+                ++run;
+            }
+
+            i32 rows = 1;
+            for (; y + rows < tilemap->height; ++rows) {
+                b32 row_is_solid = true;
+                for (i32 i = 0; i < run && row_is_solid; ++i) {
+                    row_is_solid = is_unmerged_tile(tilemap, x + i, y + rows);
+                }
+                if (!row_is_solid) {
+                    break;
+                }
+            }
+
+            v2 diagonal = tilemap->tile_size * v2 {(f32)run, (f32)rows};
+            v2 center = tilemap->origin +
+                        tilemap->tile_size * v2 {(f32)x, (f32)y} +
+                        0.5f * diagonal;
+
+            phy_body_* body = phy_add_block(state, center, diagonal, 1.0f, 0.0f);
+            body->flags = tilemap->flags | PHY_FIXED_FLAG | PHY_TILEMAP_FLAG;
+            body->inv_mass = 0.0f;
+            body->inv_moment = 0.0f;
+            body->entity = tilemap->entity;
+            tilemap->bodies.push(body);
+
+            for (i32 j = 0; j < rows; ++j) {
+                for (i32 i = 0; i < run; ++i) {
+                    i32 index = (y + j) * tilemap->width + x + i;
+                    tilemap->cell_bodies[index] = body;
+                }
+            }
+        }
+    }
+}
+
+phy_body_*
+phy_add_body(phy_state_* state) {
+    phy_body_* body = state->bodies.acquire();
+    body->aabb_node_index = -1;
+    body->dynamic_index = -1;
+    body->sleeping_index = -1;
+    body->island_next = 0;
+    body->sleep_time = 0.0f;
+    body->snapshot_id = 0;
+    state->new_bodies.push(body);
+    return body;
+}
+
+void
+phy_remove_body(phy_state_* state, phy_body_* body) {
+
+    // whatever was resting on it has to notice it's gone
+    phy_wake_body(state, body);
+    if (body->aabb_node_index != -1) {
+        state->wake_list.count = 0;
+        for (i32 i = 0; i < state->sleeping_bodies.count; ++i) {
+            phy_body_* sleeping_body = state->sleeping_bodies[i];
+            if (aabb_are_intersecting(sleeping_body->aabb, body->aabb)) {
+                state->wake_list.push(sleeping_body);
+            }
+        }
+        for (i32 i = 0; i < state->wake_list.count; ++i) {
+            phy_wake_body(state, state->wake_list[i]);
+        }
+    }
+
+    remove_pairs_for_body(state, body);
+    pair_cache_expire_body(state, body);
+    if (body->aabb_node_index != -1) {
+        aabb_remove_node(get_tree(state, body), body->aabb_node_index);
+        sap_remove(state, body);
+    } else {
+        // never got a proxy, so it's still waiting in new_bodies
+        for (i32 i = 0; i < state->new_bodies.count; ++i) {
+            if (state->new_bodies[i] == body) {
+                state->new_bodies[i] = state->new_bodies[--state->new_bodies.count];
+                break;
+            }
+        }
+    }
+    if (body->dynamic_index != -1) {
+        phy_body_* last = state->dynamic_bodies[--state->dynamic_bodies.count];
+        state->dynamic_bodies[body->dynamic_index] = last;
+        last->dynamic_index = body->dynamic_index;
+    }
+    state->hulls.free_many(body->hulls.values, body->hulls.count);
+    state->bodies.free(body);
+}
+
+array<phy_hull_>
+phy_add_hulls(phy_state_* state, i32 count) {
+    return state->hulls.acquire_many(count);
+}
+
+array<v2>
+phy_add_points(phy_state_* state, i32 count) {
+
+    return state->points.acquire_many(count);
+}
+
+phy_collision_*
+phy_add_collision(phy_state_* state) {
+    assert_(state->collisions.count < state->collisions.capacity);
+    return state->collisions.values + state->collisions.count++;
+}
+
+phy_collision_*
+phy_add_collision(phy_state_* state, phy_collision_ collision) {
+    assert_(state->collisions.count < state->collisions.capacity);
+    phy_collision_* result =
+            state->collisions.values + state->collisions.count++;
+    *result = collision;
+    return result;
+}
+
+void
+update_hulls(phy_body_* body) {
+    TIMED_FUNC();
+    m2x2 rotation = get_rotation_matrix(body->orientation);
+    for (int i = 0; i < body->hulls.count; ++i) {
+        phy_hull_* hull = body->hulls.at(i);
+        hull->position = body->position + rotation * hull->relative_position;
+        hull->orientation = body->orientation;
+    }
+}
+
+v2
+do_simplex(phy_support_result_ support,
+           phy_support_result_* simplex,
+           i32* simplex_count) {
+    v2 result;
+    switch (*simplex_count) {
+        case 1: {
+            v2 ab = support.p - simplex[0].p;
+            simplex[1] = support;
+            *simplex_count += 1;
+            result = triple(ab, ab, simplex[0].p);
+        } break;
+        case 2: {
+            //        (support) c
+            //                 / \
+            //              o?/   \ o?
+            //               /  o? \
+            // (simplex[0]) a-------b (simplex[1])
+
+            v2 a = simplex[0].p;
+            v2 b = simplex[1].p;
+            v2 c = support.p;
+
+            v2 ac = c - a;
+            // perpendicular away from b
+            v2 ac_p = triple(ac, ac, b);
+            f32 dot_acp = dot(ac_p, c);
+            if (dot_acp == 0.0f) {
+                // origin is on ac - return a collision and let EPA handle
+                // whether or not we care
+                *simplex_count += 1;
+                simplex[2] = support;
+                result = v2 {0};
+            } else if (dot_acp > 0.0f) {
+                // origin may be inside simplex - keep checking
+                v2 bc = c - b;
+                // perpendicular away from a
+                v2 bc_p = triple(bc, bc, a);
+                f32 dot_bcp = dot(bc_p, c);
+                if (dot_bcp >= 0.0f) {
+                    // origin is on bc or inside simplex
+                    *simplex_count += 1;
+                    simplex[2] = support;
+                    result = v2 {0};
+                } else {
+                    // origin is on outside of bc - replace a with c and check
+                    // perpendicular to bc away from c
+                    simplex[0] = support;
+                    result = bc_p;
+                }
+            } else {
+                // origin is on outside of ac - replace b with c and check
+                // perpendicular to ac away from b
+                simplex[1] = support;
+                result = ac_p;
+            }
+        } break;
+        default: assert_(false);
+    }
+    return result;
+}
+
+// must guarantee to populate simplex with 3 points if it returns true. starts
+// looking along d, which is best off as whatever separated the hulls last
+// time. when they turn out to be apart, d comes back as the axis that showed it
+b32
+do_gjk(phy_hull_* a, phy_hull_* b, phy_support_result_* simplex, v2* d) {
+    if (d->x == 0.0f && d->y == 0.0f) {
+        *d = v2 {1,1};
+    }
+    phy_support_result_ support = do_support(a, b, *d);
+    if (dot(support.p, *d) <= 0.0f) {
+        return false;
+    }
+    simplex[0] = support;
+    *d = -*d;
+    i32 simplex_count = 1;
+    for (int i = 0; i < 20; ++i) {
+        support = do_support(a, b, *d);
+        if (dot(support.p, *d) <= 0.0f) {
+            return false;
+        }
+
+        *d = do_simplex(support, simplex, &simplex_count);
+        if (simplex_count == 3) {
+            return true;
+        }
+    }
+    assert_(false);
+    return false;
+}
+
+// edge a to b of a counter clockwise polytope, with the normal facing out
+inline phy_edge_
+make_polytope_edge(phy_support_result_* polytope, i32 a, i32 b) {
+    v2 e = polytope[b].p - polytope[a].p;
+    phy_edge_ result;
+    result.normal = normalize(v2 {e.y, -e.x});
+    result.depth = dot(result.normal, polytope[a].p);
+    result.a = a;
+    result.b = b;
+    return result;
+}
+
+// the polytope's edges are kept in a min heap on depth, so the closest one is
+// always on top
+inline void
+push_edge(phy_edge_* heap, i32* count, phy_edge_ edge) {
+    i32 i = (*count)++;
+    while (i > 0) {
+        i32 parent = (i - 1) / 2;
+        if (heap[parent].depth <= edge.depth) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = edge;
+}
+
+inline phy_edge_
+pop_edge(phy_edge_* heap, i32* count) {
+    phy_edge_ result = heap[0];
+    phy_edge_ last = heap[--(*count)];
+    i32 i = 0;
+    for (;;) {
+        i32 child = 2 * i + 1;
+        if (child >= *count) {
+            break;
+        }
+        if (child + 1 < *count && heap[child + 1].depth < heap[child].depth) {
+            ++child;
+        }
+        if (last.depth <= heap[child].depth) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (*count) {
+        heap[i] = last;
+    }
+    return result;
+}
+
+inline void
+reorder_simplex(phy_support_result_* simplex) {
+    if (dot(perp(simplex[1].p - simplex[0].p), simplex[2].p) < 0.0f) {
+        phy_support_result_ temp = simplex[0];
+        simplex[0] = simplex[1];
+        simplex[1] = temp;
+    }
+}
+
+// expands the triangle gjk ended on out to the edge of the minkowski
+// difference nearest the origin. new points only ever get added on to the end
+// of polytope, and only the two edges a new point makes get measured. if it
+// hasn't settled after EPA_MAX_ITERATIONS, which can happen on rounded hulls,
+// the closest edge so far is close enough
+b32
+do_epa(phy_hull_* a,
+       phy_hull_* b,
+       phy_support_result_* polytope,
+       phy_edge_* result) {
+
+    reorder_simplex(polytope);
+    i32 vertex_count = 3;
+    const f32 threshold = 0.001f;
+
+    phy_edge_ heap[EPA_POLYTOPE_CAPACITY];
+    i32 edge_count = 0;
+    push_edge(heap, &edge_count, make_polytope_edge(polytope, 0, 1));
+    push_edge(heap, &edge_count, make_polytope_edge(polytope, 1, 2));
+    push_edge(heap, &edge_count, make_polytope_edge(polytope, 2, 0));
+
+    phy_edge_ edge;
+    for (i32 i = 0; i < EPA_MAX_ITERATIONS; ++i) {
+        edge = pop_edge(heap, &edge_count);
+        phy_support_result_ support = do_support(a, b, edge.normal);
+
+        f32 d = dot(support.p, edge.normal);
+        if (d - edge.depth < threshold) {
+            break;
+        }
+
+        i32 index = vertex_count++;
+        polytope[index] = support;
+        push_edge(heap, &edge_count, make_polytope_edge(polytope, edge.a, index));
+        push_edge(heap, &edge_count, make_polytope_edge(polytope, index, edge.b));
+    }
+
+    if (edge.depth > 0.0f) {
+        *result = edge;
+        return true;
+    }
+    return false;
+}
+
+b32
+collision_is_physical(phy_body_* a, phy_body_* b) {
+    if (a->flags & PHY_INCORPOREAL_FLAG || b->flags & PHY_INCORPOREAL_FLAG) {
+        return false;
+    }
+
+    if (a->flags & PHY_CHARACTER_FLAG && b->flags & PHY_CHARACTER_FLAG) {
+        return false;
+    }
+
+    return true;
+}
+
+// closest point to the origin on the segment simplex[0] to simplex[1], along
+// with the points on the hulls that make it up. drops whichever end isn't
+// needed to describe it
+inline phy_support_result_
+reduce_segment(phy_support_result_* simplex, i32* count) {
+    phy_support_result_ a = simplex[0];
+    v2 ab = simplex[1].p - a.p;
+    f32 ab_length_squared = length_squared(ab);
+    f32 t = ab_length_squared > 0.0f ? -dot(a.p, ab) / ab_length_squared : 0.0f;
+    if (t <= 0.0f) {
+        *count = 1;
+        return a;
+    }
+    if (t >= 1.0f) {
+        simplex[0] = simplex[1];
+        *count = 1;
+        return simplex[0];
+    }
+
+    phy_support_result_ result;
+    result.p = a.p + t * ab;
+    result.p_a = a.p_a + t * (simplex[1].p_a - a.p_a);
+    result.p_b = a.p_b + t * (simplex[1].p_b - a.p_b);
+    return result;
+}
+
+// gjk run for the closest point of the minkowski difference instead of just
+// whether it contains the origin. returns the distance between the hulls, or
+// 0 when they overlap. normal points from b towards a, and closest gets the
+// nearest points on each hull
+f32
+hull_distance(phy_hull_* a, phy_hull_* b, v2* normal, phy_support_result_* closest) {
+    phy_support_result_ simplex[2] = {0};
+    simplex[0] = do_support(a, b, v2 {1.0f, 0.0f});
+    i32 count = 1;
+    phy_support_result_ v = simplex[0];
+
+    for (i32 i = 0; i < 32; ++i) {
+        f32 v_length_squared = length_squared(v.p);
+        if (v_length_squared < 1e-12f) {
+            return 0.0f;
+        }
+
+        phy_support_result_ w = do_support(a, b, -v.p);
+
+        // nothing on the hulls gets closer than v, so v is the answer
+        if (v_length_squared - dot(v.p, w.p) <= 1e-6f * v_length_squared) {
+            break;
+        }
+
+        if (count == 1) {
+            simplex[1] = w;
+            count = 2;
+            v = reduce_segment(simplex, &count);
+            continue;
+        }
+
+        // with a full segment, the closest point to the origin is now on
+        // one of the two edges that share w, unless w has closed around it
+        v2 s_0 = simplex[0].p;
+        v2 s_1 = simplex[1].p;
+        f32 c_0 = flt_cross(s_1 - s_0, -s_0);
+        f32 c_1 = flt_cross(w.p - s_1, -s_1);
+        f32 c_2 = flt_cross(s_0 - w.p, -w.p);
+        if ((c_0 >= 0.0f && c_1 >= 0.0f && c_2 >= 0.0f) ||
+            (c_0 <= 0.0f && c_1 <= 0.0f && c_2 <= 0.0f)) {
+            return 0.0f;
+        }
+
+        phy_support_result_ edge_0[2] = {simplex[0], w};
+        phy_support_result_ edge_1[2] = {simplex[1], w};
+        i32 count_0 = 2, count_1 = 2;
+        phy_support_result_ v_0 = reduce_segment(edge_0, &count_0);
+        phy_support_result_ v_1 = reduce_segment(edge_1, &count_1);
+        if (length_squared(v_0.p) <= length_squared(v_1.p)) {
+            simplex[0] = edge_0[0];
+            simplex[1] = edge_0[1];
+            count = count_0;
+            v = v_0;
+        } else {
+            simplex[0] = edge_1[0];
+            simplex[1] = edge_1[1];
+            count = count_1;
+            v = v_1;
+        }
+    }
+
+    f32 distance = length(v.p);
+    *normal = (1.0f / distance) * v.p;
+    *closest = v;
+    return distance;
+}
+
+// conservative advancement: steps a along motion by as much as the gap to b
+// allows, until the gap is down to the slop. returns how far it got as a
+// fraction of motion, or 1 when a never reaches b. hulls that already touch
+// are left to the narrow phase
+f32
+hull_time_of_impact(phy_hull_* a, phy_hull_* b, v2 motion) {
+    v2 start = a->position;
+    f32 t = 0.0f;
+    f32 result = 1.0f;
+
+    for (i32 i = 0; i < 20; ++i) {
+        a->position = start + t * motion;
+
+        v2 normal;
+        phy_support_result_ closest;
+        f32 distance = hull_distance(a, b, &normal, &closest);
+        if (distance == 0.0f) {
+            // hull_distance doesn't give a normal for hulls that touch.
+            // touching from the start is the narrow phase's problem, and
+            // otherwise a got there
+            if (i > 0) {
+                result = t;
+            }
+            break;
+        }
+
+        // only a gap that's closing counts as an impact, however small. a
+        // bullet leaving a surface it started against goes all the way
+        f32 closing_distance = -dot(motion, normal);
+        if (closing_distance <= 0.0f) {
+            break;
+        }
+        if (distance < CCD_LINEAR_SLOP) {
+            result = t;
+            break;
+        }
+
+        t += (distance - 0.5f * CCD_LINEAR_SLOP) / closing_distance;
+        if (t >= 1.0f) {
+            break;
+        }
+    }
+
+    a->position = start;
+    return result;
+}
+
+// the earliest time of impact between a bullet and anything physical in the
+// tree that its swept aabb touches. other bodies are swept along with their
+// own velocity by moving the bullet relative to them
+f32
+find_time_of_impact(phy_aabb_tree_* tree,
+                    phy_body_* body,
+                    v2 motion,
+                    phy_aabb_ swept_aabb,
+                    f32 dt,
+                    f32 toi) {
+    phy_wide_tree_* wide = aabb_get_wide_tree(tree);
+    if (wide->nodes.count == 0) {
+        return toi;
+    }
+
+    i32 stack[MEDIUM_STACK_SIZE];
+    i32 stack_index = 0;
+    stack[stack_index++] = 0;
+
+    while (stack_index > 0) {
+        i32 index = stack[--stack_index];
+        i32 mask = wide_overlap_mask(wide->nodes.at(index), swept_aabb);
+        phy_wide_children_* children = wide->children.at(index);
+
+        for (i32 i = 0; i < 4; ++i) {
+            i32 child = children->index[i];
+            if (!(mask & (1 << i)) || child == WIDE_EMPTY) {
+                continue;
+            }
+
+            if (child >= 0) {
+                assert_(stack_index < (i32)ARRAY_SIZE(stack));
+                stack[stack_index++] = child;
+                continue;
+            }
+
+            phy_body_* other = tree->nodes.at(decode_wide_leaf(child))->body;
+            if (other == body || !collision_is_physical(body, other)) {
+                continue;
+            }
+
+            v2 relative_motion = motion - dt * other->velocity;
+            for (i32 j = 0; j < body->hulls.count; ++j) {
+                for (i32 k = 0; k < other->hulls.count; ++k) {
+                    toi = f32min(toi, hull_time_of_impact(body->hulls.at(j),
+                                                          other->hulls.at(k),
+                                                          relative_motion));
+                }
+            }
+        }
+    }
+
+    return toi;
+}
+
+// how much of this step's motion a bullet gets to make. when it would hit
+// something, it goes just far enough to sink in by the slop, so the narrow
+// phase sees the contact on the next step
+f32
+get_bullet_motion_fraction(phy_state_* state, phy_body_* body, v2 motion, f32 dt) {
+    TIMED_FUNC();
+
+    // moving less than half its own size, it can't skip past anything
+    v2 extent = body->aabb.max - body->aabb.min;
+    f32 motion_length = length(motion);
+    if (motion_length < 0.5f * f32min(extent.x, extent.y)) {
+        return 1.0f;
+    }
+
+    phy_aabb_ swept_aabb = body->aabb;
+    swept_aabb.min += v2 {f32min(motion.x, 0.0f), f32min(motion.y, 0.0f)};
+    swept_aabb.max += v2 {f32max(motion.x, 0.0f), f32max(motion.y, 0.0f)};
+
+    f32 toi = 1.0f;
+    toi = find_time_of_impact(&state->static_tree, body, motion, swept_aabb, dt, toi);
+    toi = find_time_of_impact(&state->dynamic_tree, body, motion, swept_aabb, dt, toi);
+    if (toi >= 1.0f) {
+        return 1.0f;
+    }
+
+    return f32min(1.0f, toi + 2.0f * CCD_LINEAR_SLOP / motion_length);
+}
+
+inline b32
+is_rect(phy_hull_* hull) {
+    return hull->type == HULL_RECT || hull->type == HULL_FILLET_RECT;
+}
+
+inline f32
+get_fillet(phy_hull_* hull) {
+    return hull->type == HULL_FILLET_RECT ? hull->fillet : 0.0f;
+}
+
+// the plain rect inside a fillet rect's rounding. anything else is its own core
+inline phy_hull_
+get_core(phy_hull_* hull) {
+    phy_hull_ result = *hull;
+    if (hull->type == HULL_FILLET_RECT) {
+        result.type = HULL_RECT;
+        result.width -= 2.0f * hull->fillet;
+        result.height -= 2.0f * hull->fillet;
+    }
+    return result;
+}
+
+inline phy_rect_
+get_rect(phy_hull_* hull) {
+    phy_rect_ result;
+    m2x2 rotation = get_rotation_matrix(hull->orientation);
+    result.radius = get_fillet(hull);
+    result.center = hull->position;
+    result.axes[0] = rotation * v2 {1.0f, 0.0f};
+    result.axes[1] = rotation * v2 {0.0f, 1.0f};
+    result.extents[0] = hull->width * 0.5f - result.radius;
+    result.extents[1] = hull->height * 0.5f - result.radius;
+    return result;
+}
+
+// how far b sits out past whichever of a's faces it's furthest out from.
+// the face's normal points towards b
+inline f32
+find_max_separation(phy_rect_* a, phy_rect_* b, i32* axis, v2* normal) {
+    v2 d = b->center - a->center;
+    f32 max = -FLT_MAX;
+    for (i32 i = 0; i < 2; ++i) {
+        v2 n = dot(d, a->axes[i]) < 0.0f ? -a->axes[i] : a->axes[i];
+        f32 separation = dot(d, n) - a->extents[i] -
+                         b->extents[0] * abs(dot(b->axes[0], n)) -
+                         b->extents[1] * abs(dot(b->axes[1], n));
+        if (separation > max) {
+            max = separation;
+            *axis = i;
+            *normal = n;
+        }
+    }
+    return max;
+}
+
+// keeps whatever part of the segment has dot(normal, p) <= offset
+inline i32
+clip_segment(v2* in, v2* out, v2 normal, f32 offset) {
+    i32 count = 0;
+    f32 d0 = dot(normal, in[0]) - offset;
+    f32 d1 = dot(normal, in[1]) - offset;
+    if (d0 <= 0.0f) {
+        out[count++] = in[0];
+    }
+    if (d1 <= 0.0f) {
+        out[count++] = in[1];
+    }
+    if (d0 * d1 < 0.0f) {
+        out[count++] = in[0] + (d0 / (d0 - d1)) * (in[1] - in[0]);
+    }
+    return count;
+}
+
+inline void
+set_local_contacts(phy_collision_* collision) {
+    phy_body_* a = collision->a;
+    phy_body_* b = collision->b;
+    collision->local_contact_a = rotate(collision->world_contact_a - a->position, -a->orientation);
+    collision->local_contact_b = rotate(collision->world_contact_b - b->position, -b->orientation);
+}
+
+// for hulls with fillets, the gap between their cores, less the fillets, as
+// one contact on the rounded surfaces. returns -1 when the cores themselves
+// overlap, since the gap doesn't say anything then
+inline i32
+collide_cores(phy_body_* a, phy_body_* b,
+              phy_hull_* a_hull, phy_hull_* b_hull,
+              phy_collision_* collisions,
+              v2* separating_axis) {
+    f32 radius = get_fillet(a_hull) + get_fillet(b_hull);
+    phy_hull_ core_a = get_core(a_hull);
+    phy_hull_ core_b = get_core(b_hull);
+    v2 normal;
+    phy_support_result_ closest;
+    f32 distance = hull_distance(&core_a, &core_b, &normal, &closest);
+    if (distance >= radius) {
+        *separating_axis = -normal;
+        return 0;
+    }
+    if (distance <= 0.0f) {
+        return -1;
+    }
+
+    v2 n = -normal;
+    phy_collision_* collision = collisions;
+    collision->a = a;
+    collision->b = b;
+    collision->normal = n;
+    collision->depth = radius - distance;
+    collision->world_contact_a = closest.p_a + get_fillet(a_hull) * n;
+    collision->world_contact_b = closest.p_b - get_fillet(b_hull) * n;
+    set_local_contacts(collision);
+    return 1;
+}
+
+// one contact for a point p of the incident rect's core, measured against the
+// reference face. returns 0 and leaves collision alone when p isn't deep enough
+inline i32
+add_rect_contact(phy_collision_* collision, phy_body_* a, phy_body_* b,
+                 phy_rect_* ref, phy_rect_* inc, v2 n, f32 face, f32 radius,
+                 v2 p, b32 flip) {
+    f32 separation = dot(n, p) - face;
+    f32 depth = radius - separation;
+    if (depth <= 0.0f) {
+        return 0;
+    }
+
+    v2 on_ref = p + (ref->radius - separation) * n;
+    v2 on_inc = p - inc->radius * n;
+
+    ZERO_STRUCT(*collision);
+    collision->a = a;
+    collision->b = b;
+    collision->depth = depth;
+    if (flip) {
+        collision->normal = -n;
+        collision->world_contact_a = on_inc;
+        collision->world_contact_b = on_ref;
+    } else {
+        collision->normal = n;
+        collision->world_contact_a = on_ref;
+        collision->world_contact_b = on_inc;
+    }
+    set_local_contacts(collision);
+    return 1;
+}
+
+// separating axes plus clipping the incident face against the reference
+// face's sides, which gets the whole manifold in one go instead of a point a
+// frame out of gjk. fillets are handled by colliding the rects without them
+// and then pushing the contacts back out to the rounded surfaces. where the
+// faces don't clip to anything, the rounded corners can still touch, and
+// the gap between the cores finds that
+i32
+collide_rects(phy_body_* a, phy_body_* b,
+              phy_hull_* a_hull, phy_hull_* b_hull,
+              phy_collision_* collisions,
+              v2* separating_axis) {
+    phy_rect_ rect_a = get_rect(a_hull);
+    phy_rect_ rect_b = get_rect(b_hull);
+    f32 radius = rect_a.radius + rect_b.radius;
+
+    i32 axis_a = 0, axis_b = 0;
+    v2 normal_a, normal_b;
+    f32 separation_a = find_max_separation(&rect_a, &rect_b, &axis_a, &normal_a);
+    if (separation_a > radius) {
+        *separating_axis = normal_a;
+        return 0;
+    }
+    f32 separation_b = find_max_separation(&rect_b, &rect_a, &axis_b, &normal_b);
+    if (separation_b > radius) {
+        *separating_axis = -normal_b;
+        return 0;
+    }
+
+    // favor a's faces, so that the reference face doesn't flip back and forth
+    // between frames when the two are about even
+    const f32 tolerance = 0.0005f;
+    b32 flip = separation_b > separation_a + tolerance;
+    phy_rect_* ref = flip ? &rect_b : &rect_a;
+    phy_rect_* inc = flip ? &rect_a : &rect_b;
+    i32 axis = flip ? axis_b : axis_a;
+    v2 n = flip ? normal_b : normal_a;
+
+    // the incident face is the one on inc that faces n the most
+    i32 inc_axis = abs(dot(inc->axes[0], n)) > abs(dot(inc->axes[1], n)) ? 0 : 1;
+    v2 inc_normal = dot(inc->axes[inc_axis], n) > 0.0f ?
+                    -inc->axes[inc_axis] : inc->axes[inc_axis];
+    v2 inc_center = inc->center + inc->extents[inc_axis] * inc_normal;
+    v2 inc_side = inc->extents[1 - inc_axis] * inc->axes[1 - inc_axis];
+    v2 incident[2] = {inc_center - inc_side, inc_center + inc_side};
+
+    v2 t = ref->axes[1 - axis];
+    f32 side = dot(t, ref->center);
+    f32 side_extent = ref->extents[1 - axis];
+
+    v2 clipped[3];
+    v2 clipped_twice[3];
+    i32 clipped_count = 0;
+    if (clip_segment(incident, clipped, t, side + side_extent) >= 2 &&
+        clip_segment(clipped, clipped_twice, -t, -side + side_extent) >= 2) {
+        clipped_count = 2;
+    }
+
+    f32 face = dot(n, ref->center) + ref->extents[axis];
+    i32 count = 0;
+    for (i32 i = 0; i < clipped_count; ++i) {
+        count += add_rect_contact(collisions + count, a, b, ref, inc, n, face, radius,
+                                  clipped_twice[i], flip);
+    }
+
+    // nothing came out of clipping, so at most the rounded corners touch
+    if (!count && radius > 0.0f) {
+        count = collide_cores(a, b, a_hull, b_hull, collisions, separating_axis);
+        if (count != -1) {
+            return count;
+        }
+
+        // the cores are touching corner to corner, which leaves the gap
+        // between them without a direction. the reference face still has one
+        v2 p = dot(n, incident[0]) < dot(n, incident[1]) ? incident[0] : incident[1];
+        return add_rect_contact(collisions, a, b, ref, inc, n, face, radius, p, flip);
+    }
+
+    // deepest first
+    if (count == 2 && collisions[1].depth > collisions[0].depth) {
+        phy_collision_ temp = collisions[0];
+        collisions[0] = collisions[1];
+        collisions[1] = temp;
+    }
+    return count;
+}
+
+#define RECT_LANES(rects, field) \
+        _mm_setr_ps(rects[0].field, rects[1].field, rects[2].field, rects[3].field)
+
+// the separating axis tests from collide_rects, on four pairs of rects at once
+// and done the same way, so the lanes come out exactly as the scalar version
+// would. returns a bit for every lane whose rects are close enough to touch.
+// the rest get the axis, from a to b, that keeps them apart
+inline i32
+rects_overlap_lanes(phy_rect_* a, phy_rect_* b, v2* separating_axes) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+    __m128 d_x = _mm_sub_ps(RECT_LANES(b, center.x), RECT_LANES(a, center.x));
+    __m128 d_y = _mm_sub_ps(RECT_LANES(b, center.y), RECT_LANES(a, center.y));
+    __m128 a0_x = RECT_LANES(a, axes[0].x);
+    __m128 a0_y = RECT_LANES(a, axes[0].y);
+    __m128 a1_x = RECT_LANES(a, axes[1].x);
+    __m128 a1_y = RECT_LANES(a, axes[1].y);
+    __m128 b0_x = RECT_LANES(b, axes[0].x);
+    __m128 b0_y = RECT_LANES(b, axes[0].y);
+    __m128 b1_x = RECT_LANES(b, axes[1].x);
+    __m128 b1_y = RECT_LANES(b, axes[1].y);
+    __m128 ea0 = RECT_LANES(a, extents[0]);
+    __m128 ea1 = RECT_LANES(a, extents[1]);
+    __m128 eb0 = RECT_LANES(b, extents[0]);
+    __m128 eb1 = RECT_LANES(b, extents[1]);
+    __m128 radius = _mm_add_ps(RECT_LANES(a, radius), RECT_LANES(b, radius));
+
+    // how much each of a's axes lines up with each of b's
+    __m128 c00 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(b0_x, a0_x), _mm_mul_ps(b0_y, a0_y)));
+    __m128 c01 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(b1_x, a0_x), _mm_mul_ps(b1_y, a0_y)));
+    __m128 c10 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(b0_x, a1_x), _mm_mul_ps(b0_y, a1_y)));
+    __m128 c11 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(b1_x, a1_x), _mm_mul_ps(b1_y, a1_y)));
+
+    __m128 da0 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(d_x, a0_x), _mm_mul_ps(d_y, a0_y)));
+    __m128 da1 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(d_x, a1_x), _mm_mul_ps(d_y, a1_y)));
+    __m128 db0 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(d_x, b0_x), _mm_mul_ps(d_y, b0_y)));
+    __m128 db1 = _mm_andnot_ps(sign_mask, _mm_add_ps(_mm_mul_ps(d_x, b1_x), _mm_mul_ps(d_y, b1_y)));
+
+    __m128 separation_a0 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(da0, ea0), _mm_mul_ps(eb0, c00)),
+                                      _mm_mul_ps(eb1, c01));
+    __m128 separation_a1 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(da1, ea1), _mm_mul_ps(eb0, c10)),
+                                      _mm_mul_ps(eb1, c11));
+    __m128 separation_b0 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(db0, eb0), _mm_mul_ps(ea0, c00)),
+                                      _mm_mul_ps(ea1, c10));
+    __m128 separation_b1 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(db1, eb1), _mm_mul_ps(ea0, c01)),
+                                      _mm_mul_ps(ea1, c11));
+
+    __m128 apart_a = _mm_cmpgt_ps(_mm_max_ps(separation_a0, separation_a1), radius);
+    __m128 apart_b = _mm_cmpgt_ps(_mm_max_ps(separation_b0, separation_b1), radius);
+    i32 mask_a = _mm_movemask_ps(apart_a);
+    i32 mask_b = _mm_movemask_ps(apart_b);
+
+    // picking out the axis is the same as in find_max_separation, just from
+    // the separations that were already worked out
+    f32 a0[4], a1[4], b0[4], b1[4];
+    _mm_storeu_ps(a0, separation_a0);
+    _mm_storeu_ps(a1, separation_a1);
+    _mm_storeu_ps(b0, separation_b0);
+    _mm_storeu_ps(b1, separation_b1);
+    for (i32 i = 0; i < 4; ++i) {
+        v2 d = b[i].center - a[i].center;
+        if (mask_a & (1 << i)) {
+            v2 axis = a1[i] > a0[i] ? a[i].axes[1] : a[i].axes[0];
+            separating_axes[i] = dot(d, axis) < 0.0f ? -axis : axis;
+        } else if (mask_b & (1 << i)) {
+            v2 axis = b1[i] > b0[i] ? b[i].axes[1] : b[i].axes[0];
+            separating_axes[i] = dot(-d, axis) < 0.0f ? axis : -axis;
+        }
+    }
+
+    return ~(mask_a | mask_b) & 0xf;
+}
+
+#undef RECT_LANES
+
+// whether every hull of a is behind every hull of b along axis
+inline b32
+is_separated_along(phy_body_* a, phy_body_* b, v2 axis) {
+    f32 max_a = -FLT_MAX;
+    for (int i = 0; i < a->hulls.count; ++i) {
+        max_a = f32max(max_a, dot(do_support(a->hulls.values + i, axis), axis));
+    }
+    for (int i = 0; i < b->hulls.count; ++i) {
+        if (dot(do_support(b->hulls.values + i, -axis), axis) <= max_a) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// fills in up to COLLISION_CAPACITY collisions, and returns how many. when
+// the hulls are apart, separating_axis gets an axis from a to b that shows it,
+// and otherwise 0. whatever's in it going in is used as a hint
+inline i32
+try_find_collision(phy_state_* state, phy_body_* a, phy_body_* b,
+                   i32 hull_index_a, i32 hull_index_b,
+                   phy_collision_ *collisions,
+                   v2* separating_axis) {
+    v2 hint = *separating_axis;
+    *separating_axis = v2 {0};
+
+    if (!a || !b) {
+        return 0;
+    }
+
+    if (a->flags & PHY_FIXED_FLAG && b->flags & PHY_FIXED_FLAG) {
+        return 0;
+    }
+
+    phy_hull_ *a_hull = a->hulls.values + hull_index_a;
+    phy_hull_ *b_hull = b->hulls.values + hull_index_b;
+    if (is_rect(a_hull) && is_rect(b_hull)) {
+        return collide_rects(a, b, a_hull, b_hull, collisions, separating_axis);
+    }
+
+    // with a fillet in the mix, the cores are usually apart, and the gap
+    // between them is a quick distance query away. epa only converges slowly
+    // on the rounded corners, so it's saved for when the cores themselves
+    // overlap
+    if (get_fillet(a_hull) > 0.0f || get_fillet(b_hull) > 0.0f) {
+        i32 count = collide_cores(a, b, a_hull, b_hull, collisions, separating_axis);
+        if (count != -1) {
+            return count;
+        }
+    }
+
+    phy_support_result_ simplex[EPA_POLYTOPE_CAPACITY] = {0};
+    if (!do_gjk(a_hull, b_hull, simplex, &hint)) {
+        *separating_axis = hint;
+        return 0;
+    }
+
+    phy_edge_ edge;
+    if (!do_epa(a_hull, b_hull, simplex, &edge)) {
+        return 0;
+    }
+
+    phy_collision_* collision = collisions;
+    collision->a = a;
+    collision->b = b;
+    collision->normal = edge.normal;
+    collision->depth = edge.depth;
+    phy_support_result_ start = simplex[edge.a];
+    phy_support_result_ fin = simplex[edge.b];
+
+    v2 p = start.p;
+    v2 e = fin.p - p;
+    v2 n = edge.normal;
+
+    f32 t = -flt_cross(p, n) / flt_cross(e, n);
+
+    v2 ae = fin.p_a - start.p_a;
+    v2 be = fin.p_b - start.p_b;
+
+    collision->world_contact_a = start.p_a + t * ae;
+    collision->world_contact_b = start.p_b + t * be;
+
+    set_local_contacts(collision);
+    return 1;
+}
+
+// fixed bodies never move, so they don't need any margin. everything else
+// gets a little room on every side, plus however far it's going to travel in
+// the near future along its velocity, so that fast bodies don't have to be
+// moved in the tree every step
+inline phy_aabb_
+make_fat_aabb(phy_body_* body) {
+    phy_aabb_ result = body->aabb;
+    if (!(body->flags & PHY_FIXED_FLAG)) {
+        result.min = body->aabb.min - FAT_AABB_MARGIN;
+        result.max = body->aabb.max + FAT_AABB_MARGIN;
+
+        v2 displacement = FAT_AABB_LOOKAHEAD * body->velocity;
+        if (displacement.x < 0.0f) {
+            result.min.x += displacement.x;
+        } else {
+            result.max.x += displacement.x;
+        }
+        if (displacement.y < 0.0f) {
+            result.min.y += displacement.y;
+        } else {
+            result.max.y += displacement.y;
+        }
+    }
+    return result;
+}
+
+void
+phy_add_aabb_for_body(phy_state_* state,
+                      phy_body_* body) {
+
+    TIMED_FUNC();
+
+    phy_aabb_tree_* tree = get_tree(state, body);
+
+    assert_(!is_freed(body));
+
+    body->aabb = get_aabb(body);
+    phy_aabb_ fat_aabb = make_fat_aabb(body);
+
+    if (body->aabb_node_index == -1) {
+        body->aabb_node_index = aabb_insert_node(tree, fat_aabb, body);
+    } else {
+        aabb_move_node(tree, body->aabb_node_index, fat_aabb);
+    }
+
+    mark_proxy_moved(state, body);
+}
+
+inline b32
+is_stale(phy_state_* state, phy_collision_* c) {
+    phy_body_* a = c->a;
+    phy_body_* b = c->b;
+    m3x3 transform_a =
+            get_translation_matrix(a->position) *
+            get_rotation_matrix_3x3(a->orientation);
+    m3x3 transform_b =
+            get_translation_matrix(b->position) *
+            get_rotation_matrix_3x3(b->orientation);
+
+    v2 new_world_a = transform_a * c->local_contact_a;
+    v2 new_world_b = transform_b * c->local_contact_b;
+
+    f32 depth = dot(new_world_b - new_world_a, c->normal);
+    if (depth > 0.0f) {
+        return true;
+    }
+    c->depth = depth;
+
+    const f32 threshold_sq = 0.002f;
+
+    if (length_squared(new_world_a - c->world_contact_a) > threshold_sq) {
+        return true;
+    }
+
+    if (length_squared(new_world_b - c->world_contact_b) > threshold_sq) {
+        return true;
+    }
+
+
+    // add_debug_point(new_world_a, 0xffffffff);
+    // add_debug_point(c->world_contact_a, 0x00000000);
+
+    return false;
+}
+
+inline b32 are_same(phy_collision_ *first, phy_collision_ *second) {
+    const f32 threshold_sq = 0.002f;
+    
+    assert_(first->a == second->a);
+    v2 distance_a = first->local_contact_a - second->local_contact_a;
+    v2 distance_b = first->local_contact_b - second->local_contact_b;
+    return length_squared(distance_a) < threshold_sq &&
+           length_squared(distance_b) < threshold_sq;
+}
+
+inline i32
+which_has_max_depth(phy_state_* state,
+                    phy_collision_* collisions,
+                    i32 count) {
+    f32 max = -FLT_MAX;
+    i32 max_index = -1;
+    for (int i = 0; i < count; ++i) {
+        if (collisions[i].depth > max) {
+            max = collisions[i].depth;
+            max_index = i;
+        }
+    }
+    return max_index;
+}
+
+// gets the furthest collision from the collision with the max depth
+inline i32
+which_is_furthest(phy_state_* state,
+                  phy_collision_* collisions,
+                  i32 count,
+                  i32 max_depth_index) {
+    f32 max = -FLT_MAX;
+    i32 max_index = -1;
+    phy_collision_ max_depth = collisions[max_depth_index];
+    for (int i = 0; i < count; ++i) {
+        if (i == max_depth_index) { continue; }
+        phy_collision_ collision = collisions[i];
+        f32 total_distance_sq_ish = length_squared(collision.world_contact_a -
+                                        max_depth.world_contact_a) +
+                                    length_squared(collision.world_contact_b -
+                                        max_depth.world_contact_b);
+        if (total_distance_sq_ish > max) {
+            max = total_distance_sq_ish;
+            max_index = i;
+        }
+    }
+    assert_(max_index != -1);
+    return max_index;
+}
+
+void
+pair_cache_init(phy_pair_cache_* cache, memory_arena_* memory, i32 capacity) {
+    assert_((capacity & (capacity - 1)) == 0);
+    cache->entries = PUSH_ARRAY(memory, capacity, phy_pair_entry_);
+    ZERO_ARRAY(cache->entries, capacity);
+    cache->count = 0;
+    cache->capacity = capacity;
+    cache->manifolds = PUSH_ARRAY(memory, capacity / 2, phy_manifold_);
+    cache->free_manifolds = PUSH_ARRAY(memory, capacity / 2, i32);
+    cache->manifold_count = 0;
+    cache->free_count = 0;
+    cache->frame = 0;
+    cache->memory = memory;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    cache->axis_hits = 0;
+    cache->axis_misses = 0;
+    cache->reuses = 0;
+    ZERO_STRUCT(cache->stats);
+}
+
+// a body's index in the pool doesn't change for as long as the body's around,
+// unlike the top half of its address
+inline u64
+get_pair_key(phy_state_* state, phy_body_* a, phy_body_* b) {
+    u64 index_a = (u64)state->bodies.index_of(a);
+    u64 index_b = (u64)state->bodies.index_of(b);
+    assert_(index_a < index_b);
+    return (index_b << 32) | index_a;
+}
+
+inline u32
+pair_cache_home(phy_pair_cache_* cache, u64 key) {
+    return _get_hashed_key(key) & ((u32)cache->capacity - 1);
+}
+
+inline phy_pair_entry_*
+pair_cache_find_slot(phy_pair_cache_* cache, u64 key) {
+    u32 mask = (u32)cache->capacity - 1;
+    u32 i = pair_cache_home(cache, key);
+    while (cache->entries[i].key && cache->entries[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return cache->entries + i;
+}
+
+inline phy_manifold_*
+pair_cache_find(phy_pair_cache_* cache, u64 key) {
+    phy_pair_entry_* entry = pair_cache_find_slot(cache, key);
+    return entry->key ? cache->manifolds + entry->manifold : 0;
+}
+
+// doubles the table and the manifolds behind it. the old arrays get left
+// behind in the arena, and any pointers to manifolds go bad
+void
+pair_cache_grow(phy_pair_cache_* cache) {
+    TIMED_FUNC();
+
+    phy_pair_entry_* old_entries = cache->entries;
+    i32 old_capacity = cache->capacity;
+    i32 capacity = 2 * old_capacity;
+
+    cache->entries = PUSH_ARRAY(cache->memory, capacity, phy_pair_entry_);
+    ZERO_ARRAY(cache->entries, capacity);
+    cache->capacity = capacity;
+    for (i32 i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].key) {
+            *pair_cache_find_slot(cache, old_entries[i].key) = old_entries[i];
+        }
+    }
+
+    phy_manifold_* manifolds = PUSH_ARRAY(cache->memory, capacity / 2, phy_manifold_);
+    memcpy(manifolds, cache->manifolds, (size_t)cache->manifold_count * sizeof(phy_manifold_));
+    cache->manifolds = manifolds;
+    i32* free_manifolds = PUSH_ARRAY(cache->memory, capacity / 2, i32);
+    memcpy(free_manifolds, cache->free_manifolds, (size_t)cache->free_count * sizeof(i32));
+    cache->free_manifolds = free_manifolds;
+}
+
+phy_manifold_*
+pair_cache_insert(phy_pair_cache_* cache, u64 key) {
+    if (2 * (cache->count + 1) > cache->capacity) {
+        pair_cache_grow(cache);
+    }
+
+    phy_pair_entry_* entry = pair_cache_find_slot(cache, key);
+    assert_(!entry->key);
+    entry->key = key;
+    entry->last_frame = cache->frame;
+    entry->separating_axis = v2 {0};
+    entry->manifold = cache->free_count ? cache->free_manifolds[--cache->free_count]
+                                        : cache->manifold_count++;
+    ++cache->count;
+
+    phy_manifold_* manifold = cache->manifolds + entry->manifold;
+    ZERO_STRUCT(*manifold);
+    return manifold;
+}
+
+// empties slot i, then walks the rest of its run, pulling back anything that
+// would no longer be found past the hole
+void
+pair_cache_remove_at(phy_pair_cache_* cache, u32 i) {
+    u32 mask = (u32)cache->capacity - 1;
+    cache->free_manifolds[cache->free_count++] = cache->entries[i].manifold;
+    --cache->count;
+
+    u32 hole = i;
+    u32 j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (!cache->entries[j].key) {
+            break;
+        }
+
+        // entries whose home is cyclically in (hole, j] can stay put
+        u32 home = pair_cache_home(cache, cache->entries[j].key);
+        b32 stays = hole <= j ? (hole < home && home <= j)
+                              : (hole < home || home <= j);
+        if (!stays) {
+            cache->entries[hole] = cache->entries[j];
+            hole = j;
+        }
+    }
+    cache->entries[hole].key = 0;
+}
+
+// starts a new frame, throwing out every pair that hasn't touched in a while
+void
+pair_cache_sweep(phy_pair_cache_* cache) {
+    TIMED_FUNC();
+
+    for (i32 i = 0; i < cache->capacity; ++i) {
+        // removing can pull a later entry back into this slot, so it has to
+        // be looked at again
+        while (cache->entries[i].key &&
+               cache->frame - cache->entries[i].last_frame > PAIR_CACHE_EXPIRE_FRAMES) {
+            pair_cache_remove_at(cache, (u32)i);
+            ++cache->evictions;
+        }
+    }
+
+    cache->stats.hits = cache->hits;
+    cache->stats.misses = cache->misses;
+    cache->stats.evictions = cache->evictions;
+    cache->stats.count = cache->count;
+    cache->stats.capacity = cache->capacity;
+    cache->stats.axis_hits = cache->axis_hits;
+    cache->stats.axis_misses = cache->axis_misses;
+    cache->stats.reuses = cache->reuses;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    cache->axis_hits = 0;
+    cache->axis_misses = 0;
+    cache->reuses = 0;
+    ++cache->frame;
+}
+
+// a removed body's index gets handed out again, so its pairs can't be left to
+// expire on their own. they go at the next sweep, before anything else can
+// touch them
+void
+pair_cache_expire_body(phy_state_* state, phy_body_* body) {
+    phy_pair_cache_* cache = &state->pair_cache;
+    u64 index = (u64)state->bodies.index_of(body);
+    for (i32 i = 0; i < cache->capacity; ++i) {
+        phy_pair_entry_* entry = cache->entries + i;
+        if (entry->key &&
+            ((entry->key >> 32) == index || (entry->key & 0xffffffff) == index)) {
+            entry->last_frame = cache->frame - PAIR_CACHE_EXPIRE_FRAMES - 1;
+        }
+    }
+}
+
+phy_pair_cache_stats_
+phy_get_pair_cache_stats(phy_state_* state) {
+    return state->pair_cache.stats;
+}
+
+phy_broad_phase_stats_
+phy_get_broad_phase_stats(phy_state_* state) {
+    return state->broad_phase_stats;
+}
+
+phy_step_stats_
+phy_get_step_stats(phy_state_* state) {
+    return state->step_stats;
+}
+
+// bodies that weren't awake for the last step haven't moved since
+v2
+phy_get_render_position(phy_state_* state, phy_body_* body) {
+    if (!body->snapshot_id || body->snapshot_id != state->snapshot_id) {
+        return body->position;
+    }
+
+    return body->previous_position +
+        state->interpolation_alpha * (body->position - body->previous_position);
+}
+
+f32
+phy_get_render_orientation(phy_state_* state, phy_body_* body) {
+    if (!body->snapshot_id || body->snapshot_id != state->snapshot_id) {
+        return body->orientation;
+    }
+
+    return body->previous_orientation +
+        state->interpolation_alpha * (body->orientation - body->previous_orientation);
+}
+
+phy_manifold_*
+get_collision_manifold(phy_state_ *state,
+                       phy_collision_ *collisions,
+                       i32 count,
+                       phy_body_ *a, phy_body_ *b) {
+    TIMED_FUNC();
+
+    // the narrow phase makes sure every touching pair has an entry
+    phy_pair_cache_* cache = &state->pair_cache;
+    phy_pair_entry_* entry = pair_cache_find_slot(cache, get_pair_key(state, a, b));
+    assert_(entry->key);
+    entry->last_frame = cache->frame;
+    phy_manifold_* manifold = cache->manifolds + entry->manifold;
+
+    phy_collision_* collision = collisions;
+    phy_manifold_ new_manifold = {0};
+    new_manifold.relative_position = manifold->relative_position;
+    new_manifold.relative_orientation = manifold->relative_orientation;
+    new_manifold.orientation_a = manifold->orientation_a;
+    if (count == COLLISION_CAPACITY) {
+        // clipping found the whole manifold at once, so the old points only
+        // matter for their impulses
+        for (int i = 0; i < count; ++i) {
+            phy_collision_ fresh = collisions[i];
+            for (int j = 0; j < manifold->collision_count; ++j) {
+                phy_collision_* c = &manifold->collisions[j];
+                if (are_same(c, &fresh)) {
+                    fresh.persistent = true;
+                    fresh.normal_impulse = c->normal_impulse;
+                    fresh.tangent_impulse = c->tangent_impulse;
+                    break;
+                }
+            }
+            new_manifold.collisions[new_manifold.collision_count++] = fresh;
+        }
+    } else {
+        phy_collision_ potential_collisions[3];
+        i32 potential_collision_index = 0;
+        potential_collisions[potential_collision_index++] = *collision;
+        for (int j = 0; j < manifold->collision_count; ++j) {
+            phy_collision_* c = &manifold->collisions[j];
+            if (are_same(c, collision)) {
+                // the same point as before, so it keeps its impulses
+                potential_collisions[0].persistent = true;
+                potential_collisions[0].normal_impulse = c->normal_impulse;
+                potential_collisions[0].tangent_impulse = c->tangent_impulse;
+            } else if (!is_stale(state, c)) {
+                c->persistent = true;
+                potential_collisions[potential_collision_index++] = *c;
+            }
+        }
+        if (potential_collision_index == 1) {
+            new_manifold.collisions[new_manifold.collision_count++] =
+                potential_collisions[--potential_collision_index];
+        } else if (potential_collision_index == 2) {
+            new_manifold.collisions[new_manifold.collision_count++] =
+                    potential_collisions[--potential_collision_index];
+            new_manifold.collisions[new_manifold.collision_count++] =
+                    potential_collisions[--potential_collision_index];
+        } else {
+            assert_(potential_collision_index == 3);
+            i32 max_depth = 0;
+            i32 furthest = which_is_furthest(state,
+                                             potential_collisions,
+                                             3,
+                                             max_depth);
+            new_manifold.collisions[new_manifold.collision_count++] =
+                    potential_collisions[max_depth];
+            new_manifold.collisions[new_manifold.collision_count++] =
+                    potential_collisions[furthest];
+        }
+    }
+
+    *manifold = new_manifold;
+    return manifold;
+}
+
+inline v2
+get_relative_position(phy_body_* a, phy_body_* b) {
+    return rotate(b->position - a->position, -a->orientation);
+}
+
+// a pair that's barely moved relative to itself since its contacts were found
+// still has the same contacts, just with slightly different depths. returns
+// how many it was able to reuse, or 0 if it needs a proper look
+inline i32
+reuse_contacts(phy_manifold_* manifold,
+               phy_body_* a, phy_body_* b,
+               phy_collision_* collisions) {
+    const f32 linear_tolerance = 0.001f;
+    const f32 angular_tolerance = 0.001f;
+
+    if (!manifold->collision_count) {
+        return 0;
+    }
+
+    v2 moved = get_relative_position(a, b) - manifold->relative_position;
+    f32 turned = (b->orientation - a->orientation) - manifold->relative_orientation;
+    if (length_squared(moved) > linear_tolerance * linear_tolerance ||
+        abs(turned) > angular_tolerance) {
+        return 0;
+    }
+
+    m3x3 transform_a =
+            get_translation_matrix(a->position) *
+            get_rotation_matrix_3x3(a->orientation);
+    m3x3 transform_b =
+            get_translation_matrix(b->position) *
+            get_rotation_matrix_3x3(b->orientation);
+    m2x2 rotation = get_rotation_matrix(a->orientation - manifold->orientation_a);
+
+    for (int i = 0; i < manifold->collision_count; ++i) {
+        phy_collision_* collision = collisions + i;
+        *collision = manifold->collisions[i];
+        collision->normal = rotation * collision->normal;
+        collision->world_contact_a = transform_a * collision->local_contact_a;
+        collision->world_contact_b = transform_b * collision->local_contact_b;
+        collision->depth = dot(collision->world_contact_a - collision->world_contact_b,
+                               collision->normal);
+        if (collision->depth <= 0.0f) {
+            return 0;
+        }
+    }
+    return manifold->collision_count;
+}
+
+// the parts of looking at a pair that don't need a search. returns whether
+// it still needs one
+b32
+start_pair_collisions(phy_state_* state, i32 index) {
+    phy_potential_collision_ potential_collision = state->potential_collisions[index];
+    phy_body_* a = potential_collision.a;
+    phy_body_* b = potential_collision.b;
+    assert_(a && b);
+
+    phy_pair_cache_* cache = &state->pair_cache;
+    phy_narrow_result_* result = state->narrow_results.at(index);
+    ZERO_STRUCT(*result);
+
+    // pairs that were apart last time tend to still be apart along the
+    // same axis, which only takes a couple of support calls to check
+    phy_pair_entry_* entry = pair_cache_find_slot(cache, get_pair_key(state, a, b));
+    if (!entry->key) {
+        return true;
+    }
+
+    v2 axis = entry->separating_axis;
+    if (axis.x != 0.0f || axis.y != 0.0f) {
+        result->axis_tested = true;
+        if (is_separated_along(a, b, axis)) {
+            result->axis_hit = true;
+            return false;
+        }
+        result->separating_axis = axis;
+    }
+
+    result->count = reuse_contacts(cache->manifolds + entry->manifold,
+                                   a, b, result->collisions);
+    result->reused = result->count != 0;
+    return !result->reused;
+}
+
+// the full search, for a pair that start_pair_collisions couldn't settle
+void
+search_pair_collisions(phy_state_* state, i32 index) {
+    phy_potential_collision_ potential_collision = state->potential_collisions[index];
+    phy_body_* a = potential_collision.a;
+    phy_body_* b = potential_collision.b;
+    phy_narrow_result_* result = state->narrow_results.at(index);
+
+    // the axis that didn't hold up is still a decent place for gjk to start
+    v2 axis = result->separating_axis;
+    result->separating_axis = v2 {0};
+
+    v2 found_axis = v2 {0};
+    for (int j = 0; j < a->hulls.count && !result->count; ++j) {
+        for (int k = 0; k < b->hulls.count && !result->count; ++k) {
+            v2 hull_axis = axis;
+            result->count = try_find_collision(state, a, b, j, k,
+                                               result->collisions, &hull_axis);
+            if (j == 0 && k == 0) {
+                found_axis = hull_axis;
+            }
+        }
+    }
+
+    if (!result->count) {
+        // an axis between the first two hulls is only any good if it keeps
+        // the rest of them apart too
+        b32 found = found_axis.x != 0.0f || found_axis.y != 0.0f;
+        if (found && (a->hulls.count > 1 || b->hulls.count > 1)) {
+            found = is_separated_along(a, b, found_axis);
+        }
+        if (found) {
+            result->separating_axis = found_axis;
+        }
+    }
+}
+
+// single rect against single rect, which covers nearly every pair
+inline b32
+is_rect_pair(phy_body_* a, phy_body_* b) {
+    return a->hulls.count == 1 && b->hulls.count == 1 &&
+           is_rect(a->hulls.values) && is_rect(b->hulls.values) &&
+           !(a->flags & PHY_FIXED_FLAG && b->flags & PHY_FIXED_FLAG);
+}
+
+// runs up to four rect pairs through the separating axis tests together.
+// only the ones that might be touching go on to the clipping
+void
+search_rect_pair_lanes(phy_state_* state, i32* indices, i32 count) {
+    phy_rect_ rects_a[4];
+    phy_rect_ rects_b[4];
+    for (i32 i = 0; i < 4; ++i) {
+        // spare lanes just redo the first pair
+        phy_potential_collision_ pair = state->potential_collisions[indices[i < count ? i : 0]];
+        rects_a[i] = get_rect(pair.a->hulls.values);
+        rects_b[i] = get_rect(pair.b->hulls.values);
+    }
+
+    v2 separating_axes[4];
+    i32 overlap = rects_overlap_lanes(rects_a, rects_b, separating_axes);
+
+    for (i32 i = 0; i < count; ++i) {
+        phy_narrow_result_* result = state->narrow_results.at(indices[i]);
+        if (overlap & (1 << i)) {
+            phy_potential_collision_ pair = state->potential_collisions[indices[i]];
+            result->separating_axis = v2 {0};
+            result->count = collide_rects(pair.a, pair.b,
+                                          pair.a->hulls.values, pair.b->hulls.values,
+                                          result->collisions,
+                                          &result->separating_axis);
+        } else {
+            result->separating_axis = separating_axes[i];
+        }
     }
-    return result;
 }
 
-// must guarantee to populate simplex with 3 points if it returns true
-b32
-do_gjk(phy_hull_* a, phy_hull_* b, phy_support_result_* simplex) {
-    TIMED_BLOCK(do_gjk);
-    v2 d = v2 {1,1};
-    phy_support_result_ support = do_support(a, b, d);
-    if (dot(support.p, d) <= 0.0f) {
-        return false;
-    }
-    simplex[0] = support;
-    d = -d;
-    i32 simplex_count = 1;
-    for (int i = 0; i < 20; ++i) {
-        support = do_support(a, b, d);
-        if (dot(support.p, d) <= 0.0f) {
-            return false;
+// everything about a run of potential collisions that can be worked out
+// without writing to anything shared, so that runs can go to different threads
+void
+find_pair_collisions(phy_state_* state, i32 start, i32 count) {
+    i32 lanes[4];
+    i32 lane_count = 0;
+    for (i32 i = start; i < start + count; ++i) {
+        if (!start_pair_collisions(state, i)) {
+            continue;
         }
 
-        d = do_simplex(support, simplex, &simplex_count);
-        if (simplex_count == 3) {
-            return true;
+        phy_potential_collision_ pair = state->potential_collisions[i];
+        if (!is_rect_pair(pair.a, pair.b)) {
+            search_pair_collisions(state, i);
+            continue;
+        }
+
+        lanes[lane_count++] = i;
+        if (lane_count == 4) {
+            search_rect_pair_lanes(state, lanes, lane_count);
+            lane_count = 0;
         }
     }
-    assert_(false);
-    return false;
+    if (lane_count) {
+        search_rect_pair_lanes(state, lanes, lane_count);
+    }
 }
 
-phy_edge_
-find_closest_edge_to_origin(phy_support_result_* polytope,
-                            i32 vertex_count) {
-    phy_edge_ result = {0};
-    result.depth = FLT_MAX;
-    result.normal = {0};
-    for (int i = 0; i < vertex_count; ++i) {
-        i32 next = (i + 1) % vertex_count;
-        v2 a = polytope[i].p;
-        v2 b = polytope[next].p;
+void
+find_pair_collisions_task(task_queue_* queue, void* data) {
+    phy_narrow_task_* task = (phy_narrow_task_*)data;
+    find_pair_collisions(task->state, task->start, task->count);
+}
 
-        assert_(!(fequals(a.x, b.x) && fequals(a.y, b.y)));
+// the pairs get looked at on the worker threads when there are enough of them.
+// everything that comes out of that is applied here on one thread, in pair
+// order, so it all comes out the same no matter how the pairs were split up
+void
+find_narrow_phase_collisions(phy_state_* state,
+                             hashmap<entity_ties_>* collision_map,
+                             platform_services_* platform) {
+    TIMED_FUNC();
 
-        v2 e = b - a;
-        v2 n = triple(e, a, e);
-        n = normalize(n);
+    i32 pair_count = state->potential_collisions.count;
+    state->narrow_results.count = pair_count;
 
-        f32 test_distance = dot(n, a);
-        if (test_distance < result.depth) {
-            result.depth = test_distance;
-            result.normal = n;
-            result.polytope_index = next;
-            result.a = i;
-            result.b = next;
+    if (!platform || pair_count < 2 * NARROW_PHASE_TASK_MIN_PAIRS) {
+        find_pair_collisions(state, 0, pair_count);
+    } else {
+        // the render queue is the one with worker threads behind it
+        task_queue_* queue = platform->render_queue;
+        i32 chunk = i32max(NARROW_PHASE_TASK_MIN_PAIRS,
+                           (pair_count + NARROW_PHASE_MAX_TASKS - 1) / NARROW_PHASE_MAX_TASKS);
+        state->narrow_tasks.count = 0;
+        for (i32 i = 0; i < pair_count; i += chunk) {
+            phy_narrow_task_* task = state->narrow_tasks.push_many(1);
+            task->state = state;
+            task->start = i;
+            task->count = i32min(chunk, pair_count - i);
+            platform->start_task(queue, find_pair_collisions_task, task);
         }
+        platform->wait_on_queue(queue);
     }
 
-    return result;
-}
+    phy_pair_cache_* cache = &state->pair_cache;
+    for (i32 i = 0; i < pair_count; ++i) {
+        phy_narrow_result_* result = state->narrow_results.at(i);
+        phy_body_* a = state->potential_collisions[i].a;
+        phy_body_* b = state->potential_collisions[i].b;
+
+        u64 key = get_pair_key(state, a, b);
+        phy_pair_entry_* entry = pair_cache_find_slot(cache, key);
+        if (result->axis_tested) {
+            entry->last_frame = cache->frame;
+            if (result->axis_hit) {
+                ++cache->axis_hits;
+                continue;
+            }
+            ++cache->axis_misses;
+        }
 
-inline void
-insert_into_polytope(phy_support_result_* polytope,
-                     i32* vertex_count,
-                     i32 index,
-                     phy_support_result_ vertex) {
-    for (i32 i = *vertex_count; i > index; --i) {
-        polytope[i] = polytope[i - 1];
+        if (!result->count) {
+            if (result->separating_axis.x != 0.0f || result->separating_axis.y != 0.0f) {
+                if (!entry->key) {
+                    pair_cache_insert(cache, key);
+                    entry = pair_cache_find_slot(cache, key);
+                }
+                entry->separating_axis = result->separating_axis;
+                cache->manifolds[entry->manifold].collision_count = 0;
+            }
+            continue;
+        }
+
+        if (entry->key) {
+            ++cache->hits;
+            entry->separating_axis = v2 {0};
+        } else {
+            ++cache->misses;
+            pair_cache_insert(cache, key);
+            entry = pair_cache_find_slot(cache, key);
+        }
+        if (result->reused) {
+            ++cache->reuses;
+        } else {
+            phy_manifold_* manifold = cache->manifolds + entry->manifold;
+            manifold->relative_position = get_relative_position(a, b);
+            manifold->relative_orientation = b->orientation - a->orientation;
+            manifold->orientation_a = a->orientation;
+        }
+
+        // touching something awake wakes a sleeping body's whole island
+        if (collision_is_physical(a, b)) {
+            phy_wake_body(state, a);
+            phy_wake_body(state, b);
+        }
+
+        // a pair's collisions go in one after another
+        for (int j = 0; j < result->count; ++j) {
+            phy_add_collision(state, result->collisions[j]);
+        }
+        set_hash_item(collision_map, a->entity.id, b->entity);
+        set_hash_item(collision_map, b->entity.id, a->entity);
     }
-    polytope[index] = vertex;
-    *vertex_count += 1;
 }
 
-inline void
-reorder_simplex(phy_support_result_* simplex) {
-    if (dot(perp(simplex[1].p - simplex[0].p), simplex[2].p) < 0.0f) {
-        phy_support_result_ temp = simplex[0];
-        simplex[0] = simplex[1];
-        simplex[1] = temp;
+void
+solver_init_manifolds(phy_solver_manifolds_* manifolds,
+                      memory_arena_* memory,
+                      i32 capacity) {
+    // room for a lane's worth past the end, so a lone manifold in the
+    // overflow color can still be loaded four at a time
+    i32 padded = capacity + 4;
+    manifolds->body_a = PUSH_ARRAY_ALIGNED(memory, padded, i32, 16);
+    manifolds->body_b = PUSH_ARRAY_ALIGNED(memory, padded, i32, 16);
+    manifolds->contact_count = PUSH_ARRAY_ALIGNED(memory, padded, i32, 16);
+    manifolds->inv_mass_a = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    manifolds->inv_moment_a = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    manifolds->inv_mass_b = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    manifolds->inv_moment_b = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+    for (i32 i = 0; i < COLLISION_CAPACITY; ++i) {
+        manifolds->normal_x[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->normal_y[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->r_a_cross_n[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->r_b_cross_n[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->r_a_cross_t[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->r_b_cross_t[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->normal_mass[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->tangent_mass[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->bias[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->normal_impulse[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->tangent_impulse[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->anchor_a_x[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->anchor_a_y[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->anchor_b_x[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->anchor_b_y[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
+        manifolds->separation[i] = PUSH_ARRAY_ALIGNED(memory, padded, f32, 16);
     }
+    manifolds->manifolds = PUSH_ARRAY(memory, padded, phy_manifold_*);
+    manifolds->count = 0;
+    manifolds->capacity = capacity;
 }
 
-b32
-do_epa(phy_hull_* a,
-       phy_hull_* b,
-       phy_support_result_* polytope,
-       phy_edge_* result) {
-
-    reorder_simplex(polytope);
-    i32 vertex_count = 3;
-    const f32 threshold = 0.001f;
+void
+solver_init_bodies(phy_solver_bodies_* bodies,
+                   memory_arena_* memory,
+                   i32 capacity) {
+    bodies->velocity_x = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->velocity_y = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->angular_velocity = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->acceleration_x = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->acceleration_y = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->angular_acceleration = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->delta_x = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->delta_y = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->delta_rotation = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->delta_cos = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->delta_sin = PUSH_ARRAY_ALIGNED(memory, capacity, f32, 16);
+    bodies->dynamic_count = 0;
+    bodies->count = 0;
+    bodies->capacity = capacity;
+}
 
-    for (int i = 0; i < 20; i++) {
-        phy_edge_ edge = find_closest_edge_to_origin(polytope,
-                                                      vertex_count);
-        phy_support_result_ support = do_support(a, b, edge.normal);
+inline i32
+solver_push_body(phy_solver_bodies_* bodies, phy_body_* body) {
+    assert_(bodies->count < bodies->capacity);
+    i32 slot = bodies->count++;
+    bodies->velocity_x[slot] = body->velocity.x;
+    bodies->velocity_y[slot] = body->velocity.y;
+    bodies->angular_velocity[slot] = body->angular_velocity;
+    bodies->delta_x[slot] = 0.0f;
+    bodies->delta_y[slot] = 0.0f;
+    bodies->delta_rotation[slot] = 0.0f;
+    bodies->delta_cos[slot] = 1.0f;
+    bodies->delta_sin[slot] = 0.0f;
+    return slot;
+}
 
-        f32 d = dot(support.p, edge.normal);
-        if (d - edge.depth < threshold) {
-            if (edge.depth > 0.0f) {
-                *result = edge;
-                return true;
-            } else {
-                return false;
-            }
-        } else {
-            insert_into_polytope(polytope,
-                                 &vertex_count,
-                                 edge.polytope_index,
-                                 support);
-        }
+inline i32
+solver_body_slot(phy_solver_bodies_* bodies, phy_body_* body) {
+    if (body->dynamic_index != -1) {
+        return body->dynamic_index;
     }
-    assert_(false);
-    return false;
+    return solver_push_body(bodies, body);
 }
 
-inline bool
-try_find_collision(phy_state_* state, phy_body_* a, phy_body_* b,
-                   i32 hull_index_a, i32 hull_index_b,
-                   phy_collision_ *collision) {
+// gets every collision's manifold up to date, then colors the physical ones
+void
+pre_solve_velocity_constraints(phy_state_* state) {
+    TIMED_FUNC();
 
-    if (!a || !b) {
-        return false;
-    }
+    vec<u64>* body_colors = &state->solver_body_colors;
+    vec<i32>* collision_colors = &state->solver_collision_colors;
+    vec<phy_solver_color_>* colors = &state->solver_colors;
 
-    if (a->flags & PHY_FIXED_FLAG && b->flags & PHY_FIXED_FLAG) {
-        return false;
-    }
+    body_colors->count = state->dynamic_bodies.count;
+    ZERO_ARRAY(body_colors->values, body_colors->count);
+    collision_colors->count = state->collisions.count;
+    colors->count = SOLVER_MAX_COLORS;
+    ZERO_ARRAY(colors->values, colors->count);
 
-    phy_support_result_ simplex[32] = {0};
-    phy_hull_ *a_hull = a->hulls.values + hull_index_a;
-    phy_hull_ *b_hull = b->hulls.values + hull_index_b;
-    if (!do_gjk(a_hull, b_hull, simplex)) {
-        return false;
-    }
+    // greedy coloring. each manifold takes the first color that neither of its
+    // dynamic bodies is in yet. fixed bodies are only ever read, so they can
+    // be in every color at once
+    for (int i = 0; i < state->collisions.count; ++i) {
+        phy_collision_ *collision = state->collisions.at(i);
+        phy_body_ *a = collision->a;
+        phy_body_ *b = collision->b;
 
-    phy_edge_ edge;
-    if (!do_epa(a_hull, b_hull, simplex, &edge)) {
-        return false;
-    }
+        assert_(a && b);
 
-    collision->a = a;
-    collision->b = b;
-    collision->normal = edge.normal;
-    collision->depth = edge.depth;
-    phy_support_result_ start = simplex[edge.a];
-    phy_support_result_ fin = simplex[edge.b];
+        // the rest of the pair's collisions ride along with the first, and
+        // don't get a color of their own
+        i32 count = 1;
+        while (i + count < state->collisions.count &&
+               state->collisions[i + count].a == a &&
+               state->collisions[i + count].b == b) {
+            (*collision_colors)[i + count] = -1;
+            ++count;
+        }
 
-    v2 p = start.p;
-    v2 e = fin.p - p;
-    v2 n = edge.normal;
+        get_collision_manifold(state, collision, count, a, b);
 
-    f32 t = -flt_cross(p, n) / flt_cross(e, n);
+        i32 index = i;
+        i += count - 1;
+        (*collision_colors)[index] = -1;
+        if (!collision_is_physical(a, b)) {
+            continue;
+        }
 
-    v2 ae = fin.p_a - start.p_a;
-    v2 be = fin.p_b - start.p_b;
+        u64 used = 0;
+        if (a->dynamic_index != -1) {
+            used |= (*body_colors)[a->dynamic_index];
+        }
+        if (b->dynamic_index != -1) {
+            used |= (*body_colors)[b->dynamic_index];
+        }
 
-    collision->world_contact_a = start.p_a + t * ae;
-    collision->world_contact_b = start.p_b + t * be;
+        // anything that doesn't fit goes in the last color, which gets solved
+        // a manifold at a time
+        i32 color = 0;
+        while (color < SOLVER_MAX_COLORS - 1 && (used & ((u64)1 << color))) {
+            ++color;
+        }
 
-    collision->local_contact_a = rotate(collision->world_contact_a - a->position, -a->orientation);
-    collision->local_contact_b = rotate(collision->world_contact_b - b->position, -b->orientation);
-    return true;
+        u64 bit = (u64)1 << color;
+        if (a->dynamic_index != -1) {
+            (*body_colors)[a->dynamic_index] |= bit;
+        }
+        if (b->dynamic_index != -1) {
+            (*body_colors)[b->dynamic_index] |= bit;
+        }
+        (*collision_colors)[index] = color;
+        ++(*colors)[color].count;
+    }
 }
 
-f32
-solve_velocity_constraint(phy_body_ *a,
-                 phy_body_ *b,
-                 f32 zeta,
-                 v6 &jacobian,
-                 f32 lambda_min,
-                 f32 lambda_max,
-                 f32* lambda_sum) {
-    v6 state = {
-        a->velocity.x, a->velocity.y, a->angular_velocity,
-        b->velocity.x, b->velocity.y, b->angular_velocity
-    };
-    v6 j2 = {
-        jacobian.vals[0] * a->inv_mass,
-        jacobian.vals[1] * a->inv_mass,
-        jacobian.vals[2] * a->inv_moment,
-        jacobian.vals[3] * b->inv_mass,
-        jacobian.vals[4] * b->inv_mass,
-        jacobian.vals[5] * b->inv_moment
-    };
+// lays the colored manifolds out flat for the solver, with everything about
+// each contact that doesn't change between iterations worked out up front.
+// the iterations only ever touch velocities and impulses. soft step anchors
+// both bodies at the middle of the contact, and warm starts every substep
+// instead of here
+void
+prepare_velocity_constraints(phy_state_* state, f32 dt) {
+    TIMED_FUNC();
+
+    b32 soft = state->solver == PHY_SOLVER_SOFT_STEP;
+
+    const f32 restitution = 0.0f; // resting contacts jitter with any more
+    const f32 baumgarte = 0.2f;
+    const f32 penetration_slop = 0.002f;
+    const f32 restitution_slop = 0.02f;
+
+    phy_solver_manifolds_* manifolds = &state->solver_manifolds;
+    phy_solver_bodies_* bodies = &state->solver_bodies;
+    vec<i32>* collision_colors = &state->solver_collision_colors;
+    vec<phy_solver_color_>* colors = &state->solver_colors;
+
+    // dynamic bodies first, then the empty slot padding points at. fixed
+    // bodies get pushed after as they come up
+    bodies->dynamic_count = state->dynamic_bodies.count;
+    bodies->count = 0;
+    for (int i = 0; i < state->dynamic_bodies.count; ++i) {
+        solver_push_body(bodies, state->dynamic_bodies[i]);
+    }
+    i32 empty_slot = bodies->count++;
+    bodies->velocity_x[empty_slot] = 0.0f;
+    bodies->velocity_y[empty_slot] = 0.0f;
+    bodies->angular_velocity[empty_slot] = 0.0f;
+    bodies->delta_x[empty_slot] = 0.0f;
+    bodies->delta_y[empty_slot] = 0.0f;
+    bodies->delta_rotation[empty_slot] = 0.0f;
+    bodies->delta_cos[empty_slot] = 1.0f;
+    bodies->delta_sin[empty_slot] = 0.0f;
+
+    i32 next[SOLVER_MAX_COLORS];
+    i32 start = 0;
+    for (i32 i = 0; i < colors->count; ++i) {
+        (*colors)[i].start = start;
+        next[i] = start;
+        start += ((*colors)[i].count + 3) & ~3;
+    }
+    assert_(start <= manifolds->capacity);
+    manifolds->count = start;
+
+    // everything starts out as padding, plus a lane's worth past the end
+    for (i32 i = 0; i < manifolds->count + 4; ++i) {
+        manifolds->body_a[i] = empty_slot;
+        manifolds->body_b[i] = empty_slot;
+        manifolds->contact_count[i] = 0;
+        manifolds->inv_mass_a[i] = 0.0f;
+        manifolds->inv_moment_a[i] = 0.0f;
+        manifolds->inv_mass_b[i] = 0.0f;
+        manifolds->inv_moment_b[i] = 0.0f;
+        manifolds->manifolds[i] = 0;
+    }
 
-    f32 effective_mass = dot(jacobian, j2);
-    f32 lagrangian = -(dot(state, jacobian) + zeta) / effective_mass;
-    f32 new_sum = fclamp(*lambda_sum + lagrangian, lambda_min, lambda_max);
-    lagrangian = new_sum - *lambda_sum;
-    *lambda_sum = new_sum;
+    for (int i = 0; i < state->collisions.count; ++i) {
+        i32 color = (*collision_colors)[i];
+        if (color == -1) {
+            continue;
+        }
 
-    v6 delta_state = lagrangian * j2;
+        phy_collision_ *collision = state->collisions.at(i);
+        phy_body_ *a = collision->a;
+        phy_body_ *b = collision->b;
+        phy_manifold_* manifold = pair_cache_find(&state->pair_cache,
+                                                  get_pair_key(state, a, b));
+        assert_(manifold);
+
+        i32 index = next[color]++;
+        manifolds->body_a[index] = solver_body_slot(bodies, a);
+        manifolds->body_b[index] = solver_body_slot(bodies, b);
+        manifolds->contact_count[index] = manifold->collision_count;
+        manifolds->inv_mass_a[index] = a->inv_mass;
+        manifolds->inv_moment_a[index] = a->inv_moment;
+        manifolds->inv_mass_b[index] = b->inv_mass;
+        manifolds->inv_moment_b[index] = b->inv_moment;
+        manifolds->manifolds[index] = manifold;
 
-    a->velocity += v2 {delta_state.vals[0], delta_state.vals[1]};
-    a->angular_velocity += delta_state.vals[2];
+        for (int j = 0; j < manifold->collision_count; ++j) {
+            phy_collision_* c = &manifold->collisions[j];
 
-    b->velocity += v2 {delta_state.vals[3], delta_state.vals[4]};
-    b->angular_velocity += delta_state.vals[5];   
+            v2 n = c->normal;
+            v2 t = v2 {n.y, -n.x};
+            v2 ra = c->world_contact_a - a->position;
+            v2 rb = c->world_contact_b - b->position;
+            if (soft) {
+                v2 middle = 0.5f * (c->world_contact_a + c->world_contact_b);
+                ra = middle - a->position;
+                rb = middle - b->position;
+            }
+            f32 ra_n = flt_cross(ra, n);
+            f32 rb_n = flt_cross(rb, n);
+            f32 ra_t = flt_cross(ra, t);
+            f32 rb_t = flt_cross(rb, t);
+            f32 normal_mass = (a->inv_mass + b->inv_mass) * dot(n, n) +
+                              a->inv_moment * ra_n * ra_n +
+                              b->inv_moment * rb_n * rb_n;
+            f32 tangent_mass = (a->inv_mass + b->inv_mass) * dot(t, t) +
+                               a->inv_moment * ra_t * ra_t +
+                               b->inv_moment * rb_t * rb_t;
+
+            // bounce back off of however fast the contact was closing
+            // before any of the solving
+            v2 relative_velocity = b->velocity - a->velocity +
+                                   cross(rb, b->angular_velocity) -
+                                   cross(ra, a->angular_velocity);
+            f32 bias = -(baumgarte / dt) *
+                       f32max(c->depth - penetration_slop, 0.0f) +
+                       restitution *
+                       f32min(dot(relative_velocity, n) + restitution_slop, 0.0f);
+
+            manifolds->normal_x[j][index] = n.x;
+            manifolds->normal_y[j][index] = n.y;
+            manifolds->r_a_cross_n[j][index] = ra_n;
+            manifolds->r_b_cross_n[j][index] = rb_n;
+            manifolds->r_a_cross_t[j][index] = ra_t;
+            manifolds->r_b_cross_t[j][index] = rb_t;
+            manifolds->normal_mass[j][index] = 1.0f / normal_mass;
+            manifolds->tangent_mass[j][index] = 1.0f / tangent_mass;
+            manifolds->bias[j][index] = bias;
+            manifolds->normal_impulse[j][index] = c->normal_impulse;
+            manifolds->tangent_impulse[j][index] = c->tangent_impulse;
+
+            if (soft) {
+                manifolds->anchor_a_x[j][index] = ra.x;
+                manifolds->anchor_a_y[j][index] = ra.y;
+                manifolds->anchor_b_x[j][index] = rb.x;
+                manifolds->anchor_b_y[j][index] = rb.y;
+                manifolds->separation[j][index] = -c->depth - dot(rb - ra, n);
+                continue;
+            }
 
-    return lagrangian;
+            // warm start with what the point ended up with last step, which
+            // is most of the way to what it'll need this step
+            v2 impulse = c->normal_impulse * n + c->tangent_impulse * t;
+            i32 slot_a = manifolds->body_a[index];
+            i32 slot_b = manifolds->body_b[index];
+            if (slot_a < bodies->dynamic_count) {
+                bodies->velocity_x[slot_a] -= a->inv_mass * impulse.x;
+                bodies->velocity_y[slot_a] -= a->inv_mass * impulse.y;
+                bodies->angular_velocity[slot_a] -=
+                        a->inv_moment * (c->normal_impulse * ra_n +
+                                         c->tangent_impulse * ra_t);
+            }
+            if (slot_b < bodies->dynamic_count) {
+                bodies->velocity_x[slot_b] += b->inv_mass * impulse.x;
+                bodies->velocity_y[slot_b] += b->inv_mass * impulse.y;
+                bodies->angular_velocity[slot_b] +=
+                        b->inv_moment * (c->normal_impulse * rb_n +
+                                         c->tangent_impulse * rb_t);
+            }
+        }
+    }
 }
 
-void
-phy_add_aabb_for_body(phy_state_* state,
-                      phy_body_* body) {
+inline __m128
+gather_lanes(f32* values, i32* slots) {
+    return _mm_setr_ps(values[slots[0]], values[slots[1]],
+                       values[slots[2]], values[slots[3]]);
+}
 
-    TIMED_FUNC();
+// writes back only the first lane_count lanes
+inline void
+store_lanes(f32* values, __m128 lanes, i32 lane_count) {
+    if (lane_count == 4) {
+        _mm_storeu_ps(values, lanes);
+        return;
+    }
 
-    phy_aabb_tree_* tree = &state->aabb_tree;
+    f32 stored[4];
+    _mm_storeu_ps(stored, lanes);
+    for (i32 i = 0; i < lane_count; ++i) {
+        values[i] = stored[i];
+    }
+}
 
-    assert_(!is_freed(body));
+inline __m128
+select_lanes(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
 
-    i32 index = -1;
-    phy_aabb_ aabb = get_aabb(body);
-    phy_aabb_ fat_aabb = phy_aabb_ {
-            aabb.min - FAT_AABB_MARGIN,
-            aabb.max + FAT_AABB_MARGIN
-    };
-    body->aabb = aabb;
-    if (tree->nodes.count == 0) { // this is our root
-        index = tree->dead_nodes.count
-                ? tree->dead_nodes[--tree->dead_nodes.count]
-                : (tree->nodes.count++);
-        phy_aabb_tree_node_* node = tree->nodes.at(index);
-        tree->root = index;
-        node->parent = -1;
-        node->body = body;
-        node->fat_aabb = fat_aabb;
-        node->type = LEAF_NODE;
-        body->aabb_node_index = index;
-    } else {
-        b32 is_asleep = body->flags & PHY_FIXED_FLAG;
-        phy_aabb_tree_node_ *parent = aabb_insert_node(tree,
-                                                        tree->root,
-                                                        fat_aabb,
-                                                        body,
-                                                        is_asleep);
-        i32 left = parent->left;
-        i32 right = parent->right;
+// the jacobian of a constraint along d, times the bodies' velocities
+inline __m128
+lanes_jacobian_velocity(phy_lane_bodies_* lanes,
+                        __m128 d_x, __m128 d_y,
+                        __m128 a_cross_d, __m128 b_cross_d) {
+    __m128 linear = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(lanes->velocity_b_x,
+                                                     lanes->velocity_a_x), d_x),
+                               _mm_mul_ps(_mm_sub_ps(lanes->velocity_b_y,
+                                                     lanes->velocity_a_y), d_y));
+    __m128 angular = _mm_sub_ps(_mm_mul_ps(lanes->angular_velocity_b, b_cross_d),
+                                _mm_mul_ps(lanes->angular_velocity_a, a_cross_d));
+    return _mm_add_ps(linear, angular);
+}
 
-        phy_body_* left_body = tree->nodes.at(left)->body;
-        phy_body_* right_body = tree->nodes.at(right)->body;
+inline void
+lanes_apply_impulse(phy_lane_bodies_* lanes,
+                    __m128 lagrangian,
+                    __m128 d_x, __m128 d_y,
+                    __m128 a_cross_d, __m128 b_cross_d) {
+    __m128 linear_a = _mm_mul_ps(lagrangian, lanes->inv_mass_a);
+    __m128 linear_b = _mm_mul_ps(lagrangian, lanes->inv_mass_b);
+    lanes->velocity_a_x = _mm_sub_ps(lanes->velocity_a_x, _mm_mul_ps(linear_a, d_x));
+    lanes->velocity_a_y = _mm_sub_ps(lanes->velocity_a_y, _mm_mul_ps(linear_a, d_y));
+    lanes->velocity_b_x = _mm_add_ps(lanes->velocity_b_x, _mm_mul_ps(linear_b, d_x));
+    lanes->velocity_b_y = _mm_add_ps(lanes->velocity_b_y, _mm_mul_ps(linear_b, d_y));
+    lanes->angular_velocity_a =
+            _mm_sub_ps(lanes->angular_velocity_a,
+                       _mm_mul_ps(_mm_mul_ps(lagrangian, lanes->inv_moment_a),
+                                  a_cross_d));
+    lanes->angular_velocity_b =
+            _mm_add_ps(lanes->angular_velocity_b,
+                       _mm_mul_ps(_mm_mul_ps(lagrangian, lanes->inv_moment_b),
+                                  b_cross_d));
+}
 
-        assert_(left_body);
-        assert_(right_body);
+inline void
+gather_lane_bodies(phy_state_* state, i32 index, phy_lane_bodies_* lanes) {
+    phy_solver_manifolds_* manifolds = &state->solver_manifolds;
+    phy_solver_bodies_* bodies = &state->solver_bodies;
+    i32* slots_a = manifolds->body_a + index;
+    i32* slots_b = manifolds->body_b + index;
+
+    lanes->velocity_a_x = gather_lanes(bodies->velocity_x, slots_a);
+    lanes->velocity_a_y = gather_lanes(bodies->velocity_y, slots_a);
+    lanes->angular_velocity_a = gather_lanes(bodies->angular_velocity, slots_a);
+    lanes->velocity_b_x = gather_lanes(bodies->velocity_x, slots_b);
+    lanes->velocity_b_y = gather_lanes(bodies->velocity_y, slots_b);
+    lanes->angular_velocity_b = gather_lanes(bodies->angular_velocity, slots_b);
+    lanes->inv_mass_a = _mm_loadu_ps(manifolds->inv_mass_a + index);
+    lanes->inv_moment_a = _mm_loadu_ps(manifolds->inv_moment_a + index);
+    lanes->inv_mass_b = _mm_loadu_ps(manifolds->inv_mass_b + index);
+    lanes->inv_moment_b = _mm_loadu_ps(manifolds->inv_moment_b + index);
+}
 
-        left_body->aabb_node_index = left;
-        right_body->aabb_node_index = right;
+// fixed bodies and padding only have read only slots
+inline void
+scatter_lane_bodies(phy_state_* state, i32 index, i32 lane_count,
+                    phy_lane_bodies_* lanes) {
+    phy_solver_manifolds_* manifolds = &state->solver_manifolds;
+    phy_solver_bodies_* bodies = &state->solver_bodies;
+    i32* slots_a = manifolds->body_a + index;
+    i32* slots_b = manifolds->body_b + index;
+
+    f32 velocity_a_x[4], velocity_a_y[4], angular_velocity_a[4];
+    f32 velocity_b_x[4], velocity_b_y[4], angular_velocity_b[4];
+    _mm_storeu_ps(velocity_a_x, lanes->velocity_a_x);
+    _mm_storeu_ps(velocity_a_y, lanes->velocity_a_y);
+    _mm_storeu_ps(angular_velocity_a, lanes->angular_velocity_a);
+    _mm_storeu_ps(velocity_b_x, lanes->velocity_b_x);
+    _mm_storeu_ps(velocity_b_y, lanes->velocity_b_y);
+    _mm_storeu_ps(angular_velocity_b, lanes->angular_velocity_b);
+
+    for (i32 i = 0; i < lane_count; ++i) {
+        i32 a = slots_a[i];
+        if (a < bodies->dynamic_count) {
+            bodies->velocity_x[a] = velocity_a_x[i];
+            bodies->velocity_y[a] = velocity_a_y[i];
+            bodies->angular_velocity[a] = angular_velocity_a[i];
+        }
+        i32 b = slots_b[i];
+        if (b < bodies->dynamic_count) {
+            bodies->velocity_x[b] = velocity_b_x[i];
+            bodies->velocity_y[b] = velocity_b_y[i];
+            bodies->angular_velocity[b] = angular_velocity_b[i];
+        }
     }
 }
 
-inline b32
-is_stale(phy_state_* state, phy_collision_* c) {
-    phy_body_* a = c->a;
-    phy_body_* b = c->b;
-    m3x3 transform_a =
-            get_translation_matrix(a->position) *
-            get_rotation_matrix_3x3(a->orientation);
-    m3x3 transform_b =
-            get_translation_matrix(b->position) *
-            get_rotation_matrix_3x3(b->orientation);
+// one pass of the solver over the four manifolds starting at index, one per
+// lane. only the first lane_count of them get written back, so the overflow
+// color can go a manifold at a time
+void
+solve_manifold_lanes(phy_state_* state, i32 index, i32 lane_count) {
+    phy_solver_manifolds_* manifolds = &state->solver_manifolds;
 
-    v2 new_world_a = transform_a * c->local_contact_a;
-    v2 new_world_b = transform_b * c->local_contact_b;
+    const __m128 friction_coefficient = _mm_set1_ps(0.1f);
+    const __m128 zero = _mm_setzero_ps();
 
-    f32 depth = dot(new_world_b - new_world_a, c->normal);
-    if (depth > 0.0f) {
-        return true;
-    }
-    c->depth = depth;
+    phy_lane_bodies_ lanes;
+    gather_lane_bodies(state, index, &lanes);
 
-    const f32 threshold_sq = 0.002f;
+    __m128i contact_count =
+            _mm_loadu_si128((__m128i*)(manifolds->contact_count + index));
 
-    if (length_squared(new_world_a - c->world_contact_a) > threshold_sq) {
-        return true;
-    }
+    for (i32 j = 0; j < COLLISION_CAPACITY; ++j) {
+        __m128 active = _mm_castsi128_ps(_mm_cmpgt_epi32(contact_count,
+                                                         _mm_set1_epi32(j)));
+        if (!_mm_movemask_ps(active)) {
+            break;
+        }
 
-    if (length_squared(new_world_b - c->world_contact_b) > threshold_sq) {
-        return true;
+        __m128 n_x = _mm_loadu_ps(manifolds->normal_x[j] + index);
+        __m128 n_y = _mm_loadu_ps(manifolds->normal_y[j] + index);
+        __m128 ra_n = _mm_loadu_ps(manifolds->r_a_cross_n[j] + index);
+        __m128 rb_n = _mm_loadu_ps(manifolds->r_b_cross_n[j] + index);
+        __m128 bias = _mm_loadu_ps(manifolds->bias[j] + index);
+        __m128 normal_sum = _mm_loadu_ps(manifolds->normal_impulse[j] + index);
+        __m128 tangent_sum = _mm_loadu_ps(manifolds->tangent_impulse[j] + index);
+
+        __m128 lagrangian =
+                _mm_mul_ps(_mm_sub_ps(zero,
+                                      _mm_add_ps(lanes_jacobian_velocity(&lanes,
+                                                                         n_x, n_y,
+                                                                         ra_n, rb_n),
+                                                 bias)),
+                           _mm_loadu_ps(manifolds->normal_mass[j] + index));
+        __m128 new_sum = _mm_max_ps(_mm_add_ps(normal_sum, lagrangian), zero);
+        lagrangian = _mm_and_ps(active, _mm_sub_ps(new_sum, normal_sum));
+        normal_sum = select_lanes(active, new_sum, normal_sum);
+        lanes_apply_impulse(&lanes, lagrangian, n_x, n_y, ra_n, rb_n);
+
+        __m128 t_x = n_y;
+        __m128 t_y = _mm_sub_ps(zero, n_x);
+        __m128 ra_t = _mm_loadu_ps(manifolds->r_a_cross_t[j] + index);
+        __m128 rb_t = _mm_loadu_ps(manifolds->r_b_cross_t[j] + index);
+
+        lagrangian = _mm_mul_ps(_mm_sub_ps(zero, lanes_jacobian_velocity(&lanes,
+                                                                         t_x, t_y,
+                                                                         ra_t, rb_t)),
+                                _mm_loadu_ps(manifolds->tangent_mass[j] + index));
+        __m128 limit = _mm_mul_ps(friction_coefficient, normal_sum);
+        new_sum = _mm_min_ps(_mm_max_ps(_mm_add_ps(tangent_sum, lagrangian),
+                                        _mm_sub_ps(zero, limit)),
+                             limit);
+        lagrangian = _mm_and_ps(active, _mm_sub_ps(new_sum, tangent_sum));
+        tangent_sum = select_lanes(active, new_sum, tangent_sum);
+        lanes_apply_impulse(&lanes, lagrangian, t_x, t_y, ra_t, rb_t);
+
+        store_lanes(manifolds->normal_impulse[j] + index, normal_sum, lane_count);
+        store_lanes(manifolds->tangent_impulse[j] + index, tangent_sum, lane_count);
     }
 
+    scatter_lane_bodies(state, index, lane_count, &lanes);
+}
 
-    // add_debug_point(new_world_a, 0xffffffff);
-    // add_debug_point(c->world_contact_a, 0x00000000);
+// soft step: applies what each contact ended up with last substep
+void
+warm_start_manifold_lanes(phy_state_* state, i32 index, i32 lane_count) {
+    phy_solver_manifolds_* manifolds = &state->solver_manifolds;
 
-    return false;
-}
+    const __m128 zero = _mm_setzero_ps();
 
-inline b32 are_same(phy_collision_ *first, phy_collision_ *second) {
-    const f32 threshold_sq = 0.002f;
-    
-    assert_(first->a == second->a);
-    v2 distance_a = first->local_contact_a - second->local_contact_a;
-    v2 distance_b = first->local_contact_b - second->local_contact_b;
-    return length_squared(distance_a) < threshold_sq &&
-           length_squared(distance_b) < threshold_sq;
-}
+    phy_lane_bodies_ lanes;
+    gather_lane_bodies(state, index, &lanes);
 
-inline i32
-which_has_max_depth(phy_state_* state,
-                    phy_collision_* collisions,
-                    i32 count) {
-    f32 max = -FLT_MAX;
-    i32 max_index = -1;
-    for (int i = 0; i < count; ++i) {
-        if (collisions[i].depth > max) {
-            max = collisions[i].depth;
-            max_index = i;
+    __m128i contact_count =
+            _mm_loadu_si128((__m128i*)(manifolds->contact_count + index));
+
+    for (i32 j = 0; j < COLLISION_CAPACITY; ++j) {
+        __m128 active = _mm_castsi128_ps(_mm_cmpgt_epi32(contact_count,
+                                                         _mm_set1_epi32(j)));
+        if (!_mm_movemask_ps(active)) {
+            break;
         }
+
+        __m128 n_x = _mm_loadu_ps(manifolds->normal_x[j] + index);
+        __m128 n_y = _mm_loadu_ps(manifolds->normal_y[j] + index);
+        __m128 normal_sum = _mm_and_ps(active,
+                _mm_loadu_ps(manifolds->normal_impulse[j] + index));
+        __m128 tangent_sum = _mm_and_ps(active,
+                _mm_loadu_ps(manifolds->tangent_impulse[j] + index));
+
+        lanes_apply_impulse(&lanes, normal_sum, n_x, n_y,
+                            _mm_loadu_ps(manifolds->r_a_cross_n[j] + index),
+                            _mm_loadu_ps(manifolds->r_b_cross_n[j] + index));
+        lanes_apply_impulse(&lanes, tangent_sum, n_y, _mm_sub_ps(zero, n_x),
+                            _mm_loadu_ps(manifolds->r_a_cross_t[j] + index),
+                            _mm_loadu_ps(manifolds->r_b_cross_t[j] + index));
     }
-    return max_index;
+
+    scatter_lane_bodies(state, index, lane_count, &lanes);
 }
 
-// gets the furthest collision from the collision with the max depth
-inline i32
-which_is_furthest(phy_state_* state,
-                  phy_collision_* collisions,
-                  i32 count,
-                  i32 max_depth_index) {
-    f32 max = -FLT_MAX;
-    i32 max_index = -1;
-    phy_collision_ max_depth = collisions[max_depth_index];
-    for (int i = 0; i < count; ++i) {
-        if (i == max_depth_index) { continue; }
-        phy_collision_ collision = collisions[i];
-        f32 total_distance_sq_ish = length_squared(collision.world_contact_a -
-                                        max_depth.world_contact_a) +
-                                    length_squared(collision.world_contact_b -
-                                        max_depth.world_contact_b);
-        if (total_distance_sq_ish > max) {
-            max = total_distance_sq_ish;
-            max_index = i;
+// soft step: one pass over four manifolds. the separation comes from how far
+// the bodies have moved since the start of the step, and anything still
+// overlapping gets pushed apart by a stiff, heavily damped spring instead of
+// a baumgarte bias. relaxing turns the spring off, so the push doesn't stay
+// in the velocities. contacts that have come apart are allowed to close the
+// gap, and no more
+void
+solve_manifold_lanes_soft(phy_state_* state, i32 index, i32 lane_count) {
+    phy_solver_manifolds_* manifolds = &state->solver_manifolds;
+    phy_solver_bodies_* bodies = &state->solver_bodies;
+    phy_softness_* softness = &state->softness;
+
+    const __m128 friction_coefficient = _mm_set1_ps(0.1f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 inv_h = _mm_set1_ps(softness->inv_h);
+    __m128 bias_rate = _mm_set1_ps(softness->bias_rate);
+    __m128 max_push = _mm_set1_ps(-softness->max_push_velocity);
+    __m128 mass_scale = _mm_set1_ps(softness->mass_scale);
+    __m128 impulse_scale = _mm_set1_ps(softness->impulse_scale);
+    if (!softness->use_bias) {
+        bias_rate = zero;
+        mass_scale = one;
+        impulse_scale = zero;
+    }
+
+    i32* slots_a = manifolds->body_a + index;
+    i32* slots_b = manifolds->body_b + index;
+
+    phy_lane_bodies_ lanes;
+    gather_lane_bodies(state, index, &lanes);
+
+    __m128 delta_x = _mm_sub_ps(gather_lanes(bodies->delta_x, slots_b),
+                                gather_lanes(bodies->delta_x, slots_a));
+    __m128 delta_y = _mm_sub_ps(gather_lanes(bodies->delta_y, slots_b),
+                                gather_lanes(bodies->delta_y, slots_a));
+    __m128 cos_a = gather_lanes(bodies->delta_cos, slots_a);
+    __m128 sin_a = gather_lanes(bodies->delta_sin, slots_a);
+    __m128 cos_b = gather_lanes(bodies->delta_cos, slots_b);
+    __m128 sin_b = gather_lanes(bodies->delta_sin, slots_b);
+
+    __m128i contact_count =
+            _mm_loadu_si128((__m128i*)(manifolds->contact_count + index));
+
+    for (i32 j = 0; j < COLLISION_CAPACITY; ++j) {
+        __m128 active = _mm_castsi128_ps(_mm_cmpgt_epi32(contact_count,
+                                                         _mm_set1_epi32(j)));
+        if (!_mm_movemask_ps(active)) {
+            break;
         }
+
+        __m128 n_x = _mm_loadu_ps(manifolds->normal_x[j] + index);
+        __m128 n_y = _mm_loadu_ps(manifolds->normal_y[j] + index);
+        __m128 ra_n = _mm_loadu_ps(manifolds->r_a_cross_n[j] + index);
+        __m128 rb_n = _mm_loadu_ps(manifolds->r_b_cross_n[j] + index);
+        __m128 normal_sum = _mm_loadu_ps(manifolds->normal_impulse[j] + index);
+        __m128 tangent_sum = _mm_loadu_ps(manifolds->tangent_impulse[j] + index);
+
+        // the anchors turned however far their bodies have
+        __m128 anchor_a_x = _mm_loadu_ps(manifolds->anchor_a_x[j] + index);
+        __m128 anchor_a_y = _mm_loadu_ps(manifolds->anchor_a_y[j] + index);
+        __m128 anchor_b_x = _mm_loadu_ps(manifolds->anchor_b_x[j] + index);
+        __m128 anchor_b_y = _mm_loadu_ps(manifolds->anchor_b_y[j] + index);
+        __m128 d_x = _mm_add_ps(delta_x,
+                _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(cos_b, anchor_b_x),
+                                      _mm_mul_ps(sin_b, anchor_b_y)),
+                           _mm_sub_ps(_mm_mul_ps(cos_a, anchor_a_x),
+                                      _mm_mul_ps(sin_a, anchor_a_y))));
+        __m128 d_y = _mm_add_ps(delta_y,
+                _mm_sub_ps(_mm_add_ps(_mm_mul_ps(sin_b, anchor_b_x),
+                                      _mm_mul_ps(cos_b, anchor_b_y)),
+                           _mm_add_ps(_mm_mul_ps(sin_a, anchor_a_x),
+                                      _mm_mul_ps(cos_a, anchor_a_y))));
+        __m128 separation = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d_x, n_x),
+                                                  _mm_mul_ps(d_y, n_y)),
+                _mm_loadu_ps(manifolds->separation[j] + index));
+
+        __m128 apart = _mm_cmpgt_ps(separation, zero);
+        __m128 bias = select_lanes(apart,
+                                   _mm_mul_ps(separation, inv_h),
+                                   _mm_max_ps(_mm_mul_ps(bias_rate, separation),
+                                              max_push));
+        __m128 lane_mass_scale = select_lanes(apart, one, mass_scale);
+        __m128 lane_impulse_scale = select_lanes(apart, zero, impulse_scale);
+
+        __m128 velocity = lanes_jacobian_velocity(&lanes, n_x, n_y, ra_n, rb_n);
+        __m128 lagrangian = _mm_sub_ps(
+                _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(manifolds->normal_mass[j] + index),
+                                      lane_mass_scale),
+                           _mm_sub_ps(zero, _mm_add_ps(velocity, bias))),
+                _mm_mul_ps(lane_impulse_scale, normal_sum));
+        __m128 new_sum = _mm_max_ps(_mm_add_ps(normal_sum, lagrangian), zero);
+        lagrangian = _mm_and_ps(active, _mm_sub_ps(new_sum, normal_sum));
+        normal_sum = select_lanes(active, new_sum, normal_sum);
+        lanes_apply_impulse(&lanes, lagrangian, n_x, n_y, ra_n, rb_n);
+
+        __m128 t_x = n_y;
+        __m128 t_y = _mm_sub_ps(zero, n_x);
+        __m128 ra_t = _mm_loadu_ps(manifolds->r_a_cross_t[j] + index);
+        __m128 rb_t = _mm_loadu_ps(manifolds->r_b_cross_t[j] + index);
+
+        lagrangian = _mm_mul_ps(_mm_sub_ps(zero, lanes_jacobian_velocity(&lanes,
+                                                                         t_x, t_y,
+                                                                         ra_t, rb_t)),
+                                _mm_loadu_ps(manifolds->tangent_mass[j] + index));
+        __m128 limit = _mm_mul_ps(friction_coefficient, normal_sum);
+        new_sum = _mm_min_ps(_mm_max_ps(_mm_add_ps(tangent_sum, lagrangian),
+                                        _mm_sub_ps(zero, limit)),
+                             limit);
+        lagrangian = _mm_and_ps(active, _mm_sub_ps(new_sum, tangent_sum));
+        tangent_sum = select_lanes(active, new_sum, tangent_sum);
+        lanes_apply_impulse(&lanes, lagrangian, t_x, t_y, ra_t, rb_t);
+
+        store_lanes(manifolds->normal_impulse[j] + index, normal_sum, lane_count);
+        store_lanes(manifolds->tangent_impulse[j] + index, tangent_sum, lane_count);
     }
-    assert_(max_index != -1);
-    return max_index;
-}
 
-phy_manifold_*
-get_collision_manifold(phy_state_ *state,
-                       phy_collision_ *collision,
-                       phy_body_ *a, phy_body_ *b) {
-    TIMED_FUNC();
+    scatter_lane_bodies(state, index, lane_count, &lanes);
+}
 
-    u64 a_64 = (u64)collision->a;
-    u64 b_64 = (u64)collision->b;
-    assert_(a_64 < b_64);
-    u64 hash_key = (b_64 << 32) | a_64;
-    phy_manifold_* manifold =
-            get_hash_item(&state->manifold_cache, hash_key);
+void
+solve_color_task(task_queue_* queue, void* data) {
+    phy_solver_task_* task = (phy_solver_task_*)data;
+    for (i32 i = 0; i < task->count; i += 4) {
+        task->solve(task->state, task->start + i, 4);
+    }
+}
 
-    phy_manifold_ new_manifold = {0};
-    if (manifold) {
-        new_manifold.normal_sum = manifold->normal_sum;
-        new_manifold.tangent_sum = manifold->tangent_sum;
-        phy_collision_ potential_collisions[3];
-        i32 potential_collision_index = 0;
-        potential_collisions[potential_collision_index++] = *collision;
-        for (int j = 0; j < manifold->collision_count; ++j) {
-            phy_collision_* c = &manifold->collisions[j];
-            if (!is_stale(state, c) && !are_same(c, collision)) {
-                c->persistent = true;
-                potential_collisions[potential_collision_index++] = *c;
+// one pass of solve over every manifold, a color at a time. nothing in a
+// color shares a dynamic body, so big colors get cut up and handed out on the
+// task queue, and every color is finished before the next one starts
+void
+solve_colors(phy_state_* state,
+             platform_services_* platform,
+             phy_solve_lanes_* solve) {
+    vec<phy_solver_color_>* colors = &state->solver_colors;
+    phy_solver_color_* overflow = colors->at(SOLVER_MAX_COLORS - 1);
+
+    for (i32 j = 0; j < SOLVER_MAX_COLORS - 1; ++j) {
+        phy_solver_color_* color = colors->at(j);
+        i32 count = (color->count + 3) & ~3;
+        if (!platform || count < 2 * SOLVER_TASK_MIN_MANIFOLDS) {
+            for (i32 k = 0; k < count; k += 4) {
+                solve(state, color->start + k, 4);
             }
+            continue;
         }
-        if (potential_collision_index == 1) {
-            new_manifold.collisions[new_manifold.collision_count++] =
-                potential_collisions[--potential_collision_index];
-        } else if (potential_collision_index == 2) {
-            new_manifold.collisions[new_manifold.collision_count++] =
-                    potential_collisions[--potential_collision_index];
-            new_manifold.collisions[new_manifold.collision_count++] =
-                    potential_collisions[--potential_collision_index];
-        } else {
-            assert_(potential_collision_index == 3);
-            i32 max_depth = 0;
-            i32 furthest = which_is_furthest(state,
-                                             potential_collisions,
-                                             3,
-                                             max_depth);
-            new_manifold.collisions[new_manifold.collision_count++] =
-                    potential_collisions[max_depth];
-            new_manifold.collisions[new_manifold.collision_count++] =
-                    potential_collisions[furthest];
+
+        // the render queue is the one with worker threads behind it
+        task_queue_* queue = platform->render_queue;
+        i32 chunk = i32max(SOLVER_TASK_MIN_MANIFOLDS,
+                           (count + SOLVER_MAX_TASKS - 1) / SOLVER_MAX_TASKS);
+        chunk = (chunk + 3) & ~3;
+        state->solver_tasks.count = 0;
+        for (i32 k = 0; k < count; k += chunk) {
+            phy_solver_task_* task = state->solver_tasks.push_many(1);
+            task->state = state;
+            task->solve = solve;
+            task->start = color->start + k;
+            task->count = i32min(chunk, count - k);
+            platform->start_task(queue, solve_color_task, task);
         }
-    } else {
-        new_manifold.collision_count = 1;
-        new_manifold.collisions[0] = *collision;
+        platform->wait_on_queue(queue);
     }
 
-    return set_hash_item(&state->manifold_cache,
-                             hash_key,
-                             new_manifold);
+    for (i32 j = 0; j < overflow->count; ++j) {
+        solve(state, overflow->start + j, 1);
+    }
 }
 
-// void
-// warm_start(phy_state_* state, phy_manifold_* manifold) {
-//     if (manifold->collision_count == 0) {
-//         return;
-//     }
-
-//     phy_body_* a = state->bodies.at(manifold->collisions[0].a_index);
-//     phy_body_* b = state->bodies.at(manifold->collisions[0].b_index);
-
-//     for (int i = 0; i < manifold->collision_count; ++i) {
-//         phy_collision_* collision = &manifold->collisions[i];
-//         if (collision->persistent) {
-//             v2 normal = collision->normal;
-//             v2 tangent = cross(normal, 1.0f);
-
-//             v2 impulse = manifold->normal_sum * normal + manifold->tangent_sum * tangent;
-//             a->velocity = a->velocity - a->inv_mass * impulse;
-//             b->velocity = b->velocity + b->inv_mass * impulse;
-//             a->angular_velocity = a->angular_velocity -
-//                     a->inv_moment * flt_cross(collision->local_contact_a, impulse);
-//             b->angular_velocity = b->angular_velocity +
-//                     b->inv_moment * flt_cross(collision->local_contact_b, impulse);
-//         }
-//     }
-// }
-
+// hands the impulses back to the manifolds, to warm start the next step with
 void
-find_narrow_phase_collisions(phy_state_* state, hashmap<entity_ties_>* collision_map) {
-    TIMED_FUNC();
-
-    for (int i = 0; i < state->potential_collisions.count; ++i) {
-        phy_potential_collision_ potential_collision = state->potential_collisions[i];
-        phy_body_* a = potential_collision.a;
-        phy_body_* b = potential_collision.b;
-        assert_(a && b);
-
-        bool found = false;
-        phy_collision_ collision = {0};
-        for (int j = 0; j < a->hulls.count && !found; ++j) {
-            for (int k = 0; k < b->hulls.count && !found; ++k) {
-                found = try_find_collision(state, a, b, j, k, &collision);
-            }
-        }
-        if (!found) {
+store_impulses(phy_state_* state) {
+    phy_solver_manifolds_* manifolds = &state->solver_manifolds;
+    for (i32 i = 0; i < manifolds->count; ++i) {
+        phy_manifold_* manifold = manifolds->manifolds[i];
+        if (!manifold) {
             continue;
         }
-        phy_add_collision(state, collision);
-        set_hash_item(collision_map, a->entity.id, b->entity);
-        set_hash_item(collision_map, b->entity.id, a->entity);
+        for (i32 j = 0; j < manifold->collision_count; ++j) {
+            manifold->collisions[j].normal_impulse = manifolds->normal_impulse[j][i];
+            manifold->collisions[j].tangent_impulse = manifolds->tangent_impulse[j][i];
+        }
     }
 }
 
 void
-pre_solve_velocity_constraints(phy_state_* state) {
+solve_velocity_constraints(phy_state_* state, platform_services_* platform) {
     TIMED_FUNC();
 
-    for (int i = 0; i < state->collisions.count; ++i) {
-        phy_collision_ *collision = state->collisions.at(i);
-        phy_body_ *a = collision->a;
-        phy_body_ *b = collision->b;
+    for (i32 i = 0; i < state->velocity_iterations; ++i) {
+        solve_colors(state, platform, solve_manifold_lanes);
+    }
 
-        assert_(a && b);
+    store_impulses(state);
 
-        phy_manifold_ *manifold = get_collision_manifold(state,
-                                                          collision,
-                                                          a, b);
-        manifold->normal_sum = 0.0f;
-        manifold->tangent_sum = 0.0f;
-    }
-}
+    phy_solver_bodies_* bodies = &state->solver_bodies;
+    for (i32 i = 0; i < state->dynamic_bodies.count; ++i) {
+        if (!state->solver_body_colors[i]) {
+            continue;
+        }
 
-b32
-collision_is_physical(phy_body_* a, phy_body_* b) {
-    if (a->flags & PHY_INCORPOREAL_FLAG || b->flags & PHY_INCORPOREAL_FLAG) {
-        return false;
-    }
+        phy_body_* body = state->dynamic_bodies[i];
+        body->velocity = v2 {bodies->velocity_x[i], bodies->velocity_y[i]};
+        body->angular_velocity = bodies->angular_velocity[i];
 
-    if (a->flags & PHY_CHARACTER_FLAG && b->flags & PHY_CHARACTER_FLAG) {
-        return false;
+        i32 body_index = state->bodies.index_of(body);
+        *(state->previous_velocities.at(body_index)) = body->velocity;
+        *(state->previous_angular_velocities.at(body_index)) = body->angular_velocity;
     }
-
-    return true;
 }
 
+// the soft step solver, after box2d v3's. collisions were found once for the
+// whole step, and each substep integrates, warm starts, solves with the
+// springs on, moves the bodies, then relaxes with them off. bodies only move
+// in the solver's arrays until the end
 void
-solve_velocity_constraints(phy_state_* state, f32 dt) {
+solve_soft_step(phy_state_* state, f32 dt, platform_services_* platform) {
     TIMED_FUNC();
 
-    for (int i = 0; i < state->collisions.count; ++i) {
-        phy_collision_ *collision = state->collisions.at(i);
-        phy_body_ *a = collision->a;
-        phy_body_ *b = collision->b;
+    phy_solver_bodies_* bodies = &state->solver_bodies;
+    assert_(state->substeps > 0);
+    f32 h = dt / (f32)state->substeps;
+
+    // the spring can't be stiffer than the substeps can follow
+    f32 hertz = f32min(SOFT_STEP_CONTACT_HERTZ, 0.25f / h);
+    f32 omega = f2PI * hertz;
+    f32 a1 = 2.0f * SOFT_STEP_DAMPING_RATIO + h * omega;
+    f32 a2 = h * omega * a1;
+    f32 a3 = 1.0f / (1.0f + a2);
+    phy_softness_* softness = &state->softness;
+    softness->bias_rate = omega / a1;
+    softness->mass_scale = a2 * a3;
+    softness->impulse_scale = a3;
+    softness->inv_h = 1.0f / h;
+    softness->max_push_velocity = SOFT_STEP_MAX_PUSH_VELOCITY;
 
-        if (!collision_is_physical(a, b)) {
-            continue;
+    f32 gravity_magnitude = length(state->gravity);
+    for (i32 i = 0; i < state->dynamic_bodies.count; ++i) {
+        phy_body_* body = state->dynamic_bodies[i];
+        v2 force = body->force;
+        if (!(body->flags & PHY_WEIGHTLESS_FLAG)) {
+            if (body->gravity_normal.x != 0.0f || body->gravity_normal.y != 0.0f) {
+                force += body->gravity_normal * body->mass * gravity_magnitude;
+            } else {
+                force += state->gravity * body->mass;
+            }
         }
+        bodies->acceleration_x[i] = force.x * body->inv_mass;
+        bodies->acceleration_y[i] = force.y * body->inv_mass;
+        bodies->angular_acceleration[i] = body->torque * body->inv_moment;
+    }
 
-        assert_(a && b);
+    f32 damping = 1.0f / (1.0f + h * 0.3f);
+    for (i32 substep = 0; substep < state->substeps; ++substep) {
+        for (i32 i = 0; i < bodies->dynamic_count; ++i) {
+            bodies->velocity_x[i] =
+                    (bodies->velocity_x[i] + bodies->acceleration_x[i] * h) * damping;
+            bodies->velocity_y[i] =
+                    (bodies->velocity_y[i] + bodies->acceleration_y[i] * h) * damping;
+            bodies->angular_velocity[i] =
+                    (bodies->angular_velocity[i] +
+                     bodies->angular_acceleration[i] * h) * damping;
+        }
 
-        phy_manifold_ *manifold = get_collision_manifold(state,
-                                                          collision,
-                                                          a, b);
+        solve_colors(state, platform, warm_start_manifold_lanes);
 
-        const f32 restitution = 0.8f;
-        const f32 friction_coefficient = 0.1f;
-        const f32 baumgarte = 0.2f;
-        const f32 penetration_slop = 0.002f;
-        const f32 restitution_slop = 0.02f;
+        softness->use_bias = true;
+        solve_colors(state, platform, solve_manifold_lanes_soft);
 
-//        warm_start(state, manifold);
+        for (i32 i = 0; i < bodies->dynamic_count; ++i) {
+            bodies->delta_x[i] += bodies->velocity_x[i] * h;
+            bodies->delta_y[i] += bodies->velocity_y[i] * h;
+            bodies->delta_rotation[i] += bodies->angular_velocity[i] * h;
+            bodies->delta_cos[i] = cos(bodies->delta_rotation[i]);
+            bodies->delta_sin[i] = sin(bodies->delta_rotation[i]);
+        }
 
-        for (int j = 0; j < manifold->collision_count; ++j) {
-            auto c = &manifold->collisions[j];
+        softness->use_bias = false;
+        solve_colors(state, platform, solve_manifold_lanes_soft);
+    }
 
-            v2 n = c->normal;
-            v2 ra = c->world_contact_a - a->position;
-            v2 rb = c->world_contact_b - b->position;
-            v2 va = a->velocity;
-            v2 vb = b->velocity;
-            f32 omega_a = a->angular_velocity;
-            f32 omega_b = b->angular_velocity;
-
-            v2 relative_velocity = vb - va +
-                                   cross(rb, omega_b) -
-                                   cross(ra, omega_a);
-
-            f32 bf = -(baumgarte / dt) *
-                     (f32)fmax(c->depth - penetration_slop, 0) +
-                     restitution *
-                     (f32)fmin(dot(relative_velocity, n) + restitution_slop, 0);
-
-            v6 jacobian = {
-                    -n.x, -n.y, -flt_cross(ra, n),
-                    n.x, n.y, flt_cross(rb, n)
-            };
+    store_impulses(state);
+
+    for (i32 i = 0; i < state->dynamic_bodies.count; ++i) {
+        phy_body_* body = state->dynamic_bodies[i];
+        body->velocity = v2 {bodies->velocity_x[i], bodies->velocity_y[i]};
+        body->angular_velocity = bodies->angular_velocity[i];
+
+        v2 motion = v2 {bodies->delta_x[i], bodies->delta_y[i]};
+        if (body->flags & PHY_BULLET_FLAG) {
+            motion *= get_bullet_motion_fraction(state, body, motion, dt);
+        }
+        body->position = body->position + motion;
+        body->orientation = body->orientation + bodies->delta_rotation[i];
+    }
+}
+
+inline i32
+find_island(phy_state_* state, i32 index) {
+    vec<i32>* parents = &state->island_parents;
+    while ((*parents)[index] != index) {
+        // path halving
+        (*parents)[index] = (*parents)[(*parents)[index]];
+        index = (*parents)[index];
+    }
+    return index;
+}
 
-            solve_velocity_constraint(a, b, bf, jacobian, 0, FLT_MAX,
-                             &manifold->normal_sum);
+// links awake bodies that touch into islands. fixed bodies don't join islands
+// together, or everything on the ground would be one island
+void
+link_islands(phy_state_* state) {
+    TIMED_FUNC();
 
-            v2 t = normalize(triple(n, relative_velocity, n));
-            if (length_squared(t) > 0) {
-                v6 tangent_jacobian = {
-                        -t.x, -t.y, -flt_cross(ra, t),
-                        t.x, t.y, flt_cross(rb, t)
-                };
+    vec<i32>* parents = &state->island_parents;
+    parents->count = state->dynamic_bodies.count;
+    for (i32 i = 0; i < parents->count; ++i) {
+        (*parents)[i] = i;
+    }
 
-                solve_velocity_constraint(a, b,
-                                 0,
-                                 tangent_jacobian,
-                                 -friction_coefficient *
-                                 manifold->normal_sum,
-                                 friction_coefficient *
-                                 manifold->normal_sum,
-                                 &manifold->tangent_sum);
-            }   
+    for (i32 i = 0; i < state->collisions.count; ++i) {
+        phy_collision_* collision = state->collisions.at(i);
+        phy_body_* a = collision->a;
+        phy_body_* b = collision->b;
+        if (a->dynamic_index == -1 || b->dynamic_index == -1 ||
+            !collision_is_physical(a, b)) {
+            continue;
         }
 
-        i32 a_index = state->bodies.index_of(a);
-        i32 b_index = state->bodies.index_of(b);
-        *(state->previous_velocities.at(a_index)) = a->velocity;
-        *(state->previous_velocities.at(b_index)) = b->velocity;
-        *(state->previous_angular_velocities.at(a_index)) = a->angular_velocity;
-        *(state->previous_angular_velocities.at(b_index)) = b->angular_velocity;
+        i32 root_a = find_island(state, a->dynamic_index);
+        i32 root_b = find_island(state, b->dynamic_index);
+        if (root_a != root_b) {
+            (*parents)[root_a] = root_b;
+        }
     }
 }
 
@@ -1468,15 +4896,13 @@ integrate_velocities(phy_state_* state, f32 dt) {
 
     f32 gravity_magnitude = length(state->gravity);
 
-    for (int i = 0; i < state->bodies.size; ++i) {
-        phy_body_* body = state->bodies.try_get(i);
-        if (!body) {
-            continue;
-        }
+    for (int i = 0; i < state->dynamic_bodies.count; ++i) {
+        phy_body_* body = state->dynamic_bodies[i];
+        i32 body_index = state->bodies.index_of(body);
 
-        *(state->previous_velocities.at(i)) = body->velocity;
-        *(state->previous_angular_velocities.at(i)) = body->angular_velocity;
-        if (!(body->flags & PHY_FIXED_FLAG) && !(body->flags & PHY_WEIGHTLESS_FLAG)) {
+        *(state->previous_velocities.at(body_index)) = body->velocity;
+        *(state->previous_angular_velocities.at(body_index)) = body->angular_velocity;
+        if (!(body->flags & PHY_WEIGHTLESS_FLAG)) {
             if (body->gravity_normal.x != 0.0f || body->gravity_normal.y != 0.0f) {
                 body->force += body->gravity_normal * body->mass * gravity_magnitude;
             } else {
@@ -1497,20 +4923,22 @@ void
 integrate_positions(phy_state_* state, f32 dt) {
     TIMED_FUNC();
 
-    for (int i = 0; i < state->bodies.size; ++i) {
-        phy_body_* body = state->bodies.try_get(i);
-
-        if (!body) {
-            continue;
-        }
+    for (int i = 0; i < state->dynamic_bodies.count; ++i) {
+        phy_body_* body = state->dynamic_bodies[i];
+        i32 body_index = state->bodies.index_of(body);
 
-        v2 avg_velocity = (body->velocity + state->previous_velocities[i]) * 0.5f;
+        v2 avg_velocity = (body->velocity + state->previous_velocities[body_index]) * 0.5f;
         f32 avg_angular_velocity =
-            (body->angular_velocity + state->previous_angular_velocities[i]) * 0.5f;
+            (body->angular_velocity +
+             state->previous_angular_velocities[body_index]) * 0.5f;
 
         f32 velocity_threshold = 0.01f;
         if (abs(length_squared(avg_velocity)) > velocity_threshold) {
-            body->position = body->position + avg_velocity * dt;
+            v2 motion = avg_velocity * dt;
+            if (body->flags & PHY_BULLET_FLAG) {
+                motion *= get_bullet_motion_fraction(state, body, motion, dt);
+            }
+            body->position = body->position + motion;
         }
         if (abs(avg_angular_velocity) > velocity_threshold) {
             body->orientation = body->orientation + avg_angular_velocity * dt;
@@ -1519,61 +4947,258 @@ integrate_positions(phy_state_* state, f32 dt) {
     }
 }
 
+// gives a body its proxy in the static or dynamic tree. fixed bodies get
+// their hulls placed here once and are never touched again
+void
+create_proxy(phy_state_* state, phy_body_* body) {
+    update_hulls(body);
+    phy_add_aabb_for_body(state, body);
+    sap_add(state, body);
+
+    if (!(body->flags & PHY_FIXED_FLAG)) {
+        body->dynamic_index = state->dynamic_bodies.count;
+        state->dynamic_bodies.push(body);
+    }
+}
+
+// gives every new body a proxy. new leaves get linked in one at a time,
+// unless there are enough of them (or bulk is set) that it's better to build
+// the tree they go in again from scratch
+void
+create_new_proxies(phy_state_* state, b32 bulk) {
+    TIMED_FUNC();
+
+    phy_aabb_tree_* trees[] = {&state->static_tree, &state->dynamic_tree};
+    for (u32 i = 0; i < ARRAY_SIZE(trees); ++i) {
+        phy_aabb_tree_* tree = trees[i];
+        vec<i32>* leaves = &state->build_leaves;
+        leaves->count = 0;
+
+        for (i32 j = 0; j < state->new_bodies.count; ++j) {
+            phy_body_* body = state->new_bodies[j];
+            if (is_freed(body) || body->aabb_node_index != -1 ||
+                get_tree(state, body) != tree) {
+                continue;
+            }
+
+            update_hulls(body);
+            body->aabb = get_aabb(body);
+            body->aabb_node_index = aabb_allocate_leaf(tree,
+                                                       make_fat_aabb(body),
+                                                       body);
+            leaves->push(body->aabb_node_index);
+            mark_proxy_moved(state, body);
+            sap_add(state, body);
+
+            if (!(body->flags & PHY_FIXED_FLAG)) {
+                body->dynamic_index = state->dynamic_bodies.count;
+                state->dynamic_bodies.push(body);
+            }
+        }
+
+        if (leaves->count >= AABB_BULK_BUILD_THRESHOLD ||
+            (bulk && leaves->count)) {
+            aabb_rebuild_tree(tree, leaves, &state->build_nodes);
+        } else {
+            for (i32 j = 0; j < leaves->count; ++j) {
+                aabb_insert_leaf(tree, (*leaves)[j]);
+            }
+        }
+    }
+
+    state->new_bodies.count = 0;
+}
+
+void
+phy_add_bodies_bulk(phy_state_* state) {
+    TIMED_FUNC();
+
+    create_new_proxies(state, true);
+}
+
+void
+phy_rebuild_tree(phy_state_* state) {
+    TIMED_FUNC();
+
+    state->build_leaves.count = 0;
+    aabb_rebuild_tree(&state->static_tree,
+                      &state->build_leaves,
+                      &state->build_nodes);
+
+    state->build_leaves.count = 0;
+    aabb_rebuild_tree(&state->dynamic_tree,
+                      &state->build_leaves,
+                      &state->build_nodes);
+}
+
 inline void
 phy_update_body(phy_state_* state, phy_body_* body) {
     TIMED_FUNC();
 
+    phy_wake_body(state, body);
+
     body->force = v2{0,0};
     body->torque = 0.0f;
-    update_hulls(body);
 
     if (body->aabb_node_index == -1) {
-        phy_add_aabb_for_body(state, body);
+        create_proxy(state, body);
     } else if (!(body->flags & PHY_FIXED_FLAG)) {
+        update_hulls(body);
         body->aabb = get_aabb(body);
         phy_aabb_ fat_aabb =
-                state->aabb_tree.nodes.at(body->aabb_node_index)->fat_aabb;
+                state->dynamic_tree.nodes.at(body->aabb_node_index)->fat_aabb;
 
         if (!aabb_is_contained_in(body->aabb, fat_aabb)) {
-            aabb_remove_node(&state->aabb_tree, body->aabb_node_index);
             phy_add_aabb_for_body(state, body);
         }
     }
 }
 
+// puts to sleep every island whose bodies have all been still for long enough. a sleeping body leaves
+// dynamic_bodies, so it costs nothing to integrate or solve, and its proxy
+// never moves
 void
-finalize_update(phy_state_* state, f32 dt) {
+update_islands(phy_state_* state, f32 dt) {
     TIMED_FUNC();
 
-    for (int i = 0; i < state->bodies.size; ++i) {
-        phy_body_* body = state->bodies.try_get(i);
-        if (!body) {
+    // the islands were linked up before solving, and nothing has woken or
+    // gone to sleep since
+    i32 count = state->dynamic_bodies.count;
+    vec<i32>* parents = &state->island_parents;
+    vec<f32>* sleep_times = &state->island_sleep_times;
+    assert_(parents->count == count);
+    sleep_times->count = count;
+
+    const f32 linear_tolerance_sq = SLEEP_LINEAR_TOLERANCE * SLEEP_LINEAR_TOLERANCE;
+    for (i32 i = 0; i < count; ++i) {
+        phy_body_* body = state->dynamic_bodies[i];
+        if (length_squared(body->velocity) > linear_tolerance_sq ||
+            abs(body->angular_velocity) > SLEEP_ANGULAR_TOLERANCE) {
+            body->sleep_time = 0.0f;
+        } else {
+            body->sleep_time += dt;
+        }
+
+        (*sleep_times)[i] = body->sleep_time;
+    }
+
+    // an island is as restless as its most restless body
+    for (i32 i = 0; i < count; ++i) {
+        i32 root = find_island(state, i);
+        (*sleep_times)[root] = f32min((*sleep_times)[root], (*sleep_times)[i]);
+    }
+
+    // each island that's ready to sleep becomes a ring through its root body
+    b32 any_asleep = false;
+    for (i32 i = 0; i < count; ++i) {
+        if ((*parents)[i] == i && (*sleep_times)[i] >= TIME_TO_SLEEP) {
+            phy_body_* root = state->dynamic_bodies[i];
+            root->island_next = root;
+            any_asleep = true;
+        }
+    }
+    if (!any_asleep) {
+        return;
+    }
+
+    for (i32 i = 0; i < count; ++i) {
+        i32 root_index = find_island(state, i);
+        if (i == root_index || (*sleep_times)[root_index] < TIME_TO_SLEEP) {
+            continue;
+        }
+        phy_body_* root = state->dynamic_bodies[root_index];
+        phy_body_* body = state->dynamic_bodies[i];
+        body->island_next = root->island_next;
+        root->island_next = body;
+    }
+
+    // going backwards, whatever gets swapped into a slot was already visited
+    for (i32 i = count - 1; i >= 0; --i) {
+        phy_body_* body = state->dynamic_bodies[i];
+        if ((*sleep_times)[find_island(state, i)] < TIME_TO_SLEEP) {
             continue;
         }
-        phy_update_body(state, body);
+
+        body->velocity = v2 {0.0f, 0.0f};
+        body->angular_velocity = 0.0f;
+
+        phy_body_* last = state->dynamic_bodies[--state->dynamic_bodies.count];
+        state->dynamic_bodies[i] = last;
+        last->dynamic_index = i;
+        body->dynamic_index = -1;
+
+        body->sleeping_index = state->sleeping_bodies.count;
+        state->sleeping_bodies.push(body);
+    }
+}
+
+void
+finalize_update(phy_state_* state, f32 dt) {
+    TIMED_FUNC();
+
+    // bodies that escaped their fat aabbs just get new ones in place, and the
+    // tree is refit in one pass once they've all been handled
+    phy_aabb_tree_* tree = &state->dynamic_tree;
+    for (int i = 0; i < state->dynamic_bodies.count; ++i) {
+        phy_body_* body = state->dynamic_bodies[i];
+        body->force = v2{0,0};
+        body->torque = 0.0f;
+
+        update_hulls(body);
+        body->aabb = get_aabb(body);
+
+        phy_aabb_tree_node_* leaf = tree->nodes.at(body->aabb_node_index);
+        if (!aabb_is_contained_in(body->aabb, leaf->fat_aabb)) {
+            leaf->fat_aabb = make_fat_aabb(body);
+            aabb_mark_moved(tree, body->aabb_node_index);
+            mark_proxy_moved(state, body);
+        }
     }
 
+    aabb_refit_moved(tree);
+
+    update_islands(state, dt);
+
     state->collisions.count = 0;
 }
 
 void
-_phy_update(phy_state_* state, hashmap<entity_ties_>* collision_map, f32 dt) {
+_phy_update(phy_state_* state,
+            hashmap<entity_ties_>* collision_map,
+            f32 dt,
+            platform_services_* platform) {
     TIMED_FUNC();
 
     state->potential_collisions.count = 0;
 
+    create_new_proxies(state, false);
+
     find_broad_phase_collisions(state);
 
-    find_narrow_phase_collisions(state, collision_map);
+    find_narrow_phase_collisions(state, collision_map, platform);
+
+    if (state->solver == PHY_SOLVER_SOFT_STEP) {
+        pre_solve_velocity_constraints(state);
+
+        prepare_velocity_constraints(state, dt);
+
+        solve_soft_step(state, dt, platform);
+
+        link_islands(state);
+
+        finalize_update(state, dt);
+        return;
+    }
 
     integrate_velocities(state, dt);
 
     pre_solve_velocity_constraints(state);
 
-    const i32 velocity_iterations = 6;
-    for (i32 i = 0; i < velocity_iterations; ++i) {
-        solve_velocity_constraints(state, dt);
-    }
+    prepare_velocity_constraints(state, dt);
+
+    solve_velocity_constraints(state, platform);
+
+    link_islands(state);
 
     integrate_positions(state, dt);
 
@@ -1581,8 +5206,8 @@ _phy_update(phy_state_* state, hashmap<entity_ties_>* collision_map, f32 dt) {
 }
 
 // void check_aabbs(phy_state_* state, phy_aabb_tree_node_* node) {
-//     phy_aabb_tree_node_* left = state->aabb_tree.nodes.at(node->left);
-//     phy_aabb_tree_node_* right = state->aabb_tree.nodes.at(node->right);
+//     phy_aabb_tree_node_* left = state->dynamic_tree.nodes.at(node->left);
+//     phy_aabb_tree_node_* right = state->dynamic_tree.nodes.at(node->right);
 
 //     if (node->type == LEAF_NODE) {
 //         assert_(aabb_is_contained_in(state->bodies.at(node->body_index)->aabb, node->fat_aabb));
@@ -1596,27 +5221,204 @@ _phy_update(phy_state_* state, hashmap<entity_ties_>* collision_map, f32 dt) {
 // }
 
 void
-phy_update(phy_state_* state, hashmap<entity_ties_>* collision_map, f32 dt) {
+phy_update(phy_state_* state,
+           hashmap<entity_ties_>* collision_map,
+           f32 dt,
+           platform_services_* platform) {
     TIMED_FUNC();
 
-
-    const i32 max_iterations = 12;
-    f32 current_time = 0;
-    f32 target_time = dt;
     assert_(state->time_step > 0);
-    for (int i = 0;
-         i < max_iterations && current_time + state->time_step <= target_time;
-        ++i) {
-        current_time += state->time_step;
-        _phy_update(state, collision_map, state->time_step);
+    assert_(state->max_substeps > 0);
+    phy_step_stats_* stats = &state->step_stats;
+    stats->dropped_time = 0.0f;
+
+    state->accumulator += dt;
+    if (state->step_policy == PHY_STEP_CLAMP &&
+        state->accumulator > state->max_frame_time) {
+        stats->dropped_time = state->accumulator - state->max_frame_time;
+        state->accumulator = state->max_frame_time;
+    }
+
+    i32 steps = (i32)(state->accumulator / state->time_step);
+    if (steps > state->max_substeps) {
+        steps = state->max_substeps;
+
+        if (state->step_policy != PHY_STEP_CLAMP) {
+            f32 kept = (f32)steps * state->time_step;
+            if (state->step_policy == PHY_STEP_SLOW_MOTION) {
+                kept += fmodf(state->accumulator, state->time_step);
+            }
+            stats->dropped_time += state->accumulator - kept;
+            state->accumulator = kept;
+        }
+    }
+
+    stats->steps = steps;
+    stats->total_dropped_time += stats->dropped_time;
+    if (stats->dropped_time > 0.0f) {
+        ++stats->overruns;
+    }
+
+    // nothing to do until a whole step's worth of time has built up. the
+    // collision map keeps what the last step found
+    if (steps) {
+        clear_hashmap(collision_map);
+
+        pair_cache_sweep(&state->pair_cache);
+
+        wake_disturbed_bodies(state);
+
+        aabb_optimize_incremental(&state->dynamic_tree,
+                                  state->dynamic_tree.optimize_budget);
+    }
+
+    for (i32 i = 0; i < steps; ++i) {
+        // only the last step's starting point matters for drawing
+        if (i == steps - 1) {
+            ++state->snapshot_id;
+            for (i32 j = 0; j < state->dynamic_bodies.count; ++j) {
+                phy_body_* body = state->dynamic_bodies[j];
+                body->previous_position = body->position;
+                body->previous_orientation = body->orientation;
+                body->snapshot_id = state->snapshot_id;
+            }
+        }
+
+        _phy_update(state, collision_map, state->time_step, platform);
+        state->accumulator -= state->time_step;
+        state->current_time += state->time_step;
     }
 
-    // check_aabbs(state, state->aabb_tree.nodes.at(state->aabb_tree.root));
+    state->interpolation_alpha =
+        fmin(fmax(state->accumulator / state->time_step, 0.0f), 1.0f);
+
+    // check_aabbs(state, state->dynamic_tree.nodes.at(state->dynamic_tree.root));
 }
 
 
 
 void
 phy_set_gravity(phy_state_* state, v2 gravity) {
+    // a change in gravity (the world rotating) unsettles everything. it's
+    // measured against what everything last woke up under, so a slow drift
+    // still adds up to a wake eventually
+    const f32 tolerance = 0.0001f;
+    if (length_squared(gravity - state->wake_gravity) > tolerance * tolerance) {
+        phy_wake_all_bodies(state);
+        state->wake_gravity = gravity;
+    }
     state->gravity = gravity;
 }
+
+inline phy_body_*
+bench_add_body(phy_state_* state, v2 center, v2 diagonal, b32 fixed) {
+    phy_body_* body = phy_add_block(state, center, diagonal, 1.0f, 0.0f);
+    body->entity.id = state->bodies.size;
+    if (fixed) {
+        body->flags |= PHY_FIXED_FLAG;
+        body->inv_mass = 0.0f;
+        body->inv_moment = 0.0f;
+    }
+    return body;
+}
+
+void
+bench_build_scene(phy_state_* state, phy_bench_scene_ scene) {
+    switch (scene) {
+        case PHY_BENCH_CORRIDOR: {
+            const i32 length = 300;
+            for (i32 x = 0; x < length; ++x) {
+                bench_add_body(state, v2 {0.5f + (f32)x, -0.5f}, v2 {1.0f, 1.0f}, true);
+                bench_add_body(state, v2 {0.5f + (f32)x, 4.5f}, v2 {1.0f, 1.0f}, true);
+            }
+            for (i32 i = 0; i < 3 * (length - 2); ++i) {
+                v2 center = v2 {1.5f + (f32)(i / 3), 0.5f + 1.2f * (f32)(i % 3)};
+                phy_body_* body = bench_add_body(state, center, v2 {0.5f, 0.5f}, false);
+                body->velocity = v2 {(f32)(i * 7 % 11 - 5), 0.0f};
+            }
+        } break;
+        case PHY_BENCH_PILE: {
+            const i32 width = 20;
+            for (i32 x = -1; x <= width; ++x) {
+                bench_add_body(state, v2 {0.5f + (f32)x, -0.5f}, v2 {1.0f, 1.0f}, true);
+            }
+            for (i32 y = 0; y < 30; ++y) {
+                bench_add_body(state, v2 {-0.5f, 0.5f + (f32)y}, v2 {1.0f, 1.0f}, true);
+                bench_add_body(state, v2 {0.5f + (f32)width, 0.5f + (f32)y}, v2 {1.0f, 1.0f}, true);
+            }
+            for (i32 i = 0; i < width * width; ++i) {
+                // every other row shifted a little, so the pile doesn't stand
+                // in neat columns
+                v2 center = v2 {0.5f + (f32)(i % width) + 0.1f * (f32)(i / width % 2),
+                                0.5f + 1.1f * (f32)(i / width)};
+                bench_add_body(state, center, v2 {0.9f, 0.9f}, false);
+            }
+        } break;
+        default: {
+            assert_(false);
+        } break;
+    }
+}
+
+// both backends hand out pairs sorted the same way, and the bodies were
+// added in the same order, so matching ids means matching pairs
+inline b32
+bench_same_pairs(phy_state_* a, phy_state_* b) {
+    if (a->potential_collisions.count != b->potential_collisions.count) {
+        return false;
+    }
+    for (i32 i = 0; i < a->potential_collisions.count; ++i) {
+        phy_potential_collision_ pair_a = a->potential_collisions[i];
+        phy_potential_collision_ pair_b = b->potential_collisions[i];
+        if (pair_a.a->entity.id != pair_b.a->entity.id ||
+            pair_a.b->entity.id != pair_b.b->entity.id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+phy_bench_broad_phase(memory_arena_* memory, phy_bench_result_* results) {
+    const i32 steps = 600;
+    const i32 collision_capacity = 8000;
+    const phy_broad_phase_ broad_phases[2] = {PHY_BROAD_PHASE_TREE, PHY_BROAD_PHASE_SAP};
+
+    for (i32 scene = 0; scene < PHY_BENCH_SCENE_COUNT; ++scene) {
+        phy_bench_result_* result = results + scene;
+        ZERO_STRUCT(*result);
+        result->steps = steps;
+
+        // everything the pools hand out is expected to start zeroed
+        u32 start = memory->used;
+        phy_state_ states[2];
+        hashmap<entity_ties_> collision_maps[2];
+        for (i32 i = 0; i < 2; ++i) {
+            states[i] = phy_init(memory, broad_phases[i]);
+            collision_maps[i].pairs.values = PUSH_ARRAY(memory, collision_capacity,
+                                                        hashpair<entity_ties_>);
+            collision_maps[i].pairs.count = collision_capacity;
+            phy_set_gravity(states + i, v2 {0.0f, -20.0f});
+            bench_build_scene(states + i, (phy_bench_scene_)scene);
+            phy_add_bodies_bulk(states + i);
+        }
+
+        // a dt of exactly one time_step takes exactly one step
+        for (i32 step = 0; step < steps; ++step) {
+            for (i32 i = 0; i < 2; ++i) {
+                phy_update(states + i, collision_maps + i, states[i].time_step, 0);
+                result->pairs[i] += states[i].potential_collisions.count;
+            }
+            if (!bench_same_pairs(states, states + 1)) {
+                ++result->mismatched_steps;
+            }
+        }
+
+        for (i32 i = 0; i < 2; ++i) {
+            result->cycles[i] = states[i].broad_phase_stats.cycles[broad_phases[i]];
+        }
+
+        memset(memory->base + start, 0, memory->used - start);
+        memory->used = start;
+    }
+}
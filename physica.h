@@ -10,9 +10,35 @@
 #include "hashmap.h"
 
 const i32 LEAF_NODE = -1;
+const i32 WIDE_EMPTY = -1;
 const v2 FAT_AABB_MARGIN = v2 {0.2f, 0.2f};
+const f32 FAT_AABB_LOOKAHEAD = 1.0f / 30.0f; // seconds of travel to allow for
+const f32 CCD_LINEAR_SLOP = 0.005f; // how far from a surface a bullet stops
+const f32 SLEEP_LINEAR_TOLERANCE = 0.1f;   // m/s
+const f32 SLEEP_ANGULAR_TOLERANCE = 0.1f;  // rad/s
+const f32 TIME_TO_SLEEP = 0.5f;            // seconds spent under both
+const i32 AABB_BUILD_BIN_COUNT = 16;
+const i32 AABB_BULK_BUILD_THRESHOLD = 64;
+const i32 SOLVER_VELOCITY_ITERATIONS = 6;
+const f32 SOLVER_TIME_STEP = 1.0f / 240.0f;
+const i32 SOFT_STEP_SUBSTEPS = 4;
+const f32 SOFT_STEP_TIME_STEP = 1.0f / 60.0f; // substeps make up the difference
+const f32 SOFT_STEP_CONTACT_HERTZ = 30.0f;
+const f32 SOFT_STEP_DAMPING_RATIO = 10.0f;
+const f32 SOFT_STEP_MAX_PUSH_VELOCITY = 3.0f; // m/s
+const i32 PAIR_CACHE_INITIAL_CAPACITY = 4096; // a power of two
+const u32 PAIR_CACHE_EXPIRE_FRAMES = 30; // manifolds untouched this long go
+const i32 SOLVER_MAX_COLORS = 64;  // one bit each in a u64. the last is overflow
+const i32 SOLVER_TASK_MIN_MANIFOLDS = 64; // colors smaller than this stay on one thread
+const i32 SOLVER_MAX_TASKS = 32;   // per color
+const i32 NARROW_PHASE_TASK_MIN_PAIRS = 64; // fewer pairs than this stay on one thread
+const i32 NARROW_PHASE_MAX_TASKS = 32;
+const i32 EPA_MAX_ITERATIONS = 24;
+const i32 EPA_POLYTOPE_CAPACITY = 3 + EPA_MAX_ITERATIONS; // gjk's triangle, plus a point an iteration
 
 struct phy_body_;
+struct phy_state_;
+struct platform_services_;
 
 struct phy_aabb_ {
     v2 min, max;
@@ -20,7 +46,6 @@ struct phy_aabb_ {
 
 struct phy_aabb_tree_node_ {
     i32 parent;
-    b32 is_asleep;
     union {
         struct {
             i32 type;
@@ -32,13 +57,52 @@ struct phy_aabb_tree_node_ {
         };
     };
     phy_aabb_ fat_aabb;
+    i32 height; // 0 for leaves
+    b32 moved;  // waiting on aabb_refit_moved
+};
+
+// the bounds of a wide node's four children side by side, so one sse compare
+// can test all of them. exactly one cache line
+struct phy_wide_node_ {
+    f32 min_x[4];
+    f32 min_y[4];
+    f32 max_x[4];
+    f32 max_y[4];
+};
+
+// indices of another wide node, encoded binary tree leaves, or WIDE_EMPTY
+struct phy_wide_children_ {
+    i32 index[4];
+};
+
+// a read only 4 wide copy of a binary tree, used for queries. the root is
+// always node 0
+struct phy_wide_tree_ {
+    vec<phy_wide_node_> nodes;
+    vec<phy_wide_children_> children;
+    u32 version; // of the binary tree this was built from
 };
 
 struct phy_aabb_tree_ {
     vec<phy_aabb_tree_node_> nodes;
     vec<i32> dead_nodes;
-    array<b32> checked_parents;
     i32 root;
+
+    // bumped whenever the tree changes, so the wide copy knows it's stale
+    u32 version;
+    phy_wide_tree_ wide;
+
+    // leaves reinserted per phy_update by the incremental optimizer, and
+    // where it left off
+    i32 optimize_budget;
+    u32 optimize_path;
+};
+
+// a run of leaves waiting to be split up by the top down tree build
+struct phy_build_range_ {
+    i32 start, count;
+    i32 parent;
+    b32 is_left;
 };
 
 enum hull_type_ {
@@ -69,7 +133,15 @@ struct phy_edge_ {
     i32 a;
     i32 b;
     f32 depth;
-    i32 polytope_index;
+};
+
+// a rect or fillet rect hull shrunk down by its fillet, for the box vs box
+// narrow phase
+struct phy_rect_ {
+    v2 center;
+    v2 axes[2];
+    f32 extents[2];
+    f32 radius; // the fillet, 0 for a plain rect
 };
 
 struct phy_support_result_ {
@@ -83,6 +155,8 @@ const u32 PHY_WEIGHTLESS_FLAG   = 0x02;
 const u32 PHY_INCORPOREAL_FLAG  = 0x04;
 const u32 PHY_GROUND_FLAG       = 0x08;
 const u32 PHY_CHARACTER_FLAG    = 0x10;
+const u32 PHY_TILEMAP_FLAG      = 0x20;
+const u32 PHY_BULLET_FLAG       = 0x40; // swept against the world every step
 
 struct phy_collision_ {
     v2 normal;
@@ -91,13 +165,53 @@ struct phy_collision_ {
     v2 local_contact_a, local_contact_b;
     v2 world_contact_a, world_contact_b;
     phy_body_ *a, *b;
+    f32 normal_impulse, tangent_impulse; // from the last step, for warm starting
 };
 
 const i32 COLLISION_CAPACITY = 2;
 struct phy_manifold_ {
     i32 collision_count;
-    f32 normal_sum, tangent_sum;
     phy_collision_ collisions[COLLISION_CAPACITY];
+
+    // where b was relative to a, and which way a faced, when the collisions
+    // were last found rather than reused
+    v2 relative_position;
+    f32 relative_orientation;
+    f32 orientation_a;
+};
+
+// a manifold for every pair of bodies that's touched lately, keyed by the
+// bodies' indices in the pool. open addressing with linear probing, and it
+// doubles whenever it gets half full. pairs that haven't touched in a while
+// get swept out once a frame
+struct phy_pair_entry_ {
+    u64 key; // 0 for an empty slot
+    u32 last_frame;
+    i32 manifold; // into manifolds
+    v2 separating_axis; // from a to b, or 0 when the pair last touched
+};
+
+struct phy_pair_cache_stats_ {
+    i32 hits, misses, evictions;
+    i32 count, capacity;
+    i32 axis_hits, axis_misses; // separated pairs that did or didn't stay that way
+    i32 reuses; // resting pairs that kept their contacts
+};
+
+struct phy_pair_cache_ {
+    phy_pair_entry_* entries;
+    i32 count, capacity;
+
+    // half as many as there are entries, since that's as full as it gets
+    phy_manifold_* manifolds;
+    i32* free_manifolds;
+    i32 manifold_count, free_count;
+
+    u32 frame;
+    memory_arena_* memory; // what it grows out of
+    i32 hits, misses, evictions; // since the last sweep
+    i32 axis_hits, axis_misses, reuses;
+    phy_pair_cache_stats_ stats; // for the last full frame
 };
 
 struct phy_potential_collision_ {
@@ -105,6 +219,22 @@ struct phy_potential_collision_ {
     phy_body_* b;
 };
 
+// what the narrow phase found out about one potential collision. these get
+// filled in on whatever thread, and only applied afterwards, in pair order
+struct phy_narrow_result_ {
+    i32 count; // collisions found, 0 when the pair's apart
+    phy_collision_ collisions[COLLISION_CAPACITY];
+    b32 reused; // the collisions came straight out of the pair's manifold
+    b32 axis_tested, axis_hit; // against the pair's cached separating axis
+    v2 separating_axis; // a new one, when count is 0
+};
+
+// a run of potential collisions, looked at as one task
+struct phy_narrow_task_ {
+    phy_state_* state;
+    i32 start, count;
+};
+
 struct entity_ties_ {
     i64 id;
     i32 type;
@@ -116,26 +246,263 @@ struct phy_body_ {
     f32 mass, inv_mass, moment, inv_moment;
     v2 position, velocity;
     f32 orientation, angular_velocity;
+    v2 previous_position; // before the last step, for interpolating
+    f32 previous_orientation;
+    u32 snapshot_id; // previous_ is only good while this matches the state's
     v2 gravity_normal;
     v2 force; // zeroed after integration
     f32 torque; // zeroed after integration
     phy_aabb_ aabb;
     i32 aabb_node_index;
+    i32 dynamic_index; // index into dynamic_bodies, -1 for fixed bodies
+    b32 proxy_moved; // set while the body sits in the broad phase move buffer
+    f32 sleep_time;  // how long the body has been still
+    i32 sleeping_index; // index into sleeping_bodies, -1 while awake
+    phy_body_* island_next; // ring of the bodies that fell asleep together
     array<phy_hull_> hulls;
 };
 
+// a grid of solid and empty cells. for collision, the solid cells get merged
+// into a few big fixed rect bodies. ray casts march the grid instead
+struct phy_tilemap_ {
+    v2 origin; // min corner of cell (0, 0). y goes up
+    f32 tile_size;
+    i32 width, height;
+    u32 flags;            // given to every body made for the tilemap
+    entity_ties_ entity;  // likewise
+    u8* solid;
+    phy_body_** cell_bodies; // the merged body covering each solid cell
+    vec<phy_body_*> bodies;
+};
+
+// every physical manifold in structure of arrays form, for the contact
+// solver. they're sorted by color, and every color starts on a multiple of
+// four, so the solver can work on four manifolds at a time, one per sse lane.
+// no two manifolds in a color share a dynamic body
+struct phy_solver_manifolds_ {
+    i32* body_a; // into solver_bodies
+    i32* body_b;
+    i32* contact_count;
+    f32* inv_mass_a;
+    f32* inv_moment_a;
+    f32* inv_mass_b;
+    f32* inv_moment_b;
+
+    // per contact in the manifold
+    f32* normal_x[COLLISION_CAPACITY];
+    f32* normal_y[COLLISION_CAPACITY];
+    f32* r_a_cross_n[COLLISION_CAPACITY];
+    f32* r_b_cross_n[COLLISION_CAPACITY];
+    f32* r_a_cross_t[COLLISION_CAPACITY]; // the tangent is the normal turned
+    f32* r_b_cross_t[COLLISION_CAPACITY]; // a quarter turn clockwise
+    f32* normal_mass[COLLISION_CAPACITY]; // inverse of the effective mass
+    f32* tangent_mass[COLLISION_CAPACITY];
+    f32* bias[COLLISION_CAPACITY]; // baumgarte plus the restitution target
+    f32* normal_impulse[COLLISION_CAPACITY];
+    f32* tangent_impulse[COLLISION_CAPACITY];
+
+    // soft step only. where the contact was on each body at the start of the
+    // step, and its separation less what the anchors account for
+    f32* anchor_a_x[COLLISION_CAPACITY];
+    f32* anchor_a_y[COLLISION_CAPACITY];
+    f32* anchor_b_x[COLLISION_CAPACITY];
+    f32* anchor_b_y[COLLISION_CAPACITY];
+    f32* separation[COLLISION_CAPACITY];
+
+    phy_manifold_** manifolds; // 0 for padding
+    i32 count, capacity;
+};
+
+// velocities of every body the solver touches. dynamic bodies sit at their
+// dynamic_index. fixed bodies get a read only slot per manifold after those,
+// and padding points at one last empty slot
+struct phy_solver_bodies_ {
+    f32* velocity_x;
+    f32* velocity_y;
+    f32* angular_velocity;
+
+    // soft step only. what gravity and forces do to the velocity, and how
+    // far the body has moved and turned since the start of the step
+    f32* acceleration_x;
+    f32* acceleration_y;
+    f32* angular_acceleration;
+    f32* delta_x;
+    f32* delta_y;
+    f32* delta_rotation;
+    f32* delta_cos;
+    f32* delta_sin;
+
+    i32 dynamic_count;
+    i32 count, capacity;
+};
+
+struct phy_solver_color_ {
+    i32 start, count;
+};
+
+// one pass over the four manifolds starting at index, writing back only the
+// first lane_count of them
+typedef void phy_solve_lanes_(phy_state_* state, i32 index, i32 lane_count);
+
+// a run of one color, solved as one task
+struct phy_solver_task_ {
+    phy_state_* state;
+    phy_solve_lanes_* solve;
+    i32 start, count;
+};
+
+// baumgarte runs the whole pipeline every time_step and pushes contacts
+// apart with a velocity bias. soft step only finds collisions once per
+// time_step, then solves substeps of it against the contacts' anchors, with
+// springy contacts instead of the bias. that holds up at a much longer
+// time_step, SOFT_STEP_TIME_STEP, where baumgarte wants SOLVER_TIME_STEP
+enum phy_solver_ {
+    PHY_SOLVER_BAUMGARTE = 0,
+    PHY_SOLVER_SOFT_STEP = 1
+};
+
+// how stiff soft step contacts are for the current substep length
+struct phy_softness_ {
+    f32 bias_rate, mass_scale, impulse_scale;
+    f32 inv_h; // one over the substep length
+    f32 max_push_velocity;
+    b32 use_bias; // off while relaxing
+};
+
+enum phy_broad_phase_ {
+    PHY_BROAD_PHASE_TREE = 0,
+    PHY_BROAD_PHASE_SAP = 1
+};
+
+// cycles spent finding potential collisions, indexed by backend. switching
+// back and forth on the same scene compares them
+struct phy_broad_phase_stats_ {
+    u64 cycles[2];
+    i32 steps[2];
+};
+
+// the scenes phy_bench_broad_phase runs. the corridor is a long strip of
+// small bodies going back and forth, which is what sweep and prune is for,
+// and the pile is a tight heap that settles and goes to sleep
+enum phy_bench_scene_ {
+    PHY_BENCH_CORRIDOR = 0,
+    PHY_BENCH_PILE = 1,
+    PHY_BENCH_SCENE_COUNT = 2
+};
+
+// totals over every step of one scene, indexed by backend
+struct phy_bench_result_ {
+    u64 cycles[2];
+    i64 pairs[2]; // potential collisions
+    i32 steps;
+    i32 mismatched_steps; // where the backends didn't come up with the same pairs
+};
+
+// what happens to time that doesn't fit in max_substeps. clamp keeps up to
+// max_frame_time of it and catches up over the next few frames, slow motion
+// lets the world fall behind by whatever didn't fit, drop also throws away
+// the partial step so the next frame starts clean
+enum phy_step_policy_ {
+    PHY_STEP_CLAMP = 0,
+    PHY_STEP_SLOW_MOTION = 1,
+    PHY_STEP_DROP = 2
+};
+
+struct phy_step_stats_ {
+    i32 steps; // substeps run last frame
+    f32 dropped_time; // last frame
+    f32 total_dropped_time;
+    i32 overruns; // frames that lost time
+};
+
+// bodies' aabbs in structure of arrays form, sorted by min_x
+struct phy_sap_intervals_ {
+    f32* min_x;
+    f32* max_x;
+    f32* min_y;
+    f32* max_y;
+    phy_body_** bodies;
+    i32 count, capacity;
+    b32 unsorted;  // bodies were added since the last sort
+    f32 max_width; // of any interval along x
+};
+
+// sweep and prune keeps its own copy of every proxy, split the same way as the
+// trees. the trees are still kept up for ray casts and picking
+struct phy_sap_ {
+    phy_sap_intervals_ dynamic_intervals;
+    phy_sap_intervals_ static_intervals;
+};
+
 struct phy_state_ {
     iterable_pool<phy_body_> bodies;
+    vec<phy_body_*> new_bodies;     // bodies that don't have a proxy yet
+    vec<phy_body_*> dynamic_bodies; // every awake body with a proxy in dynamic_tree
+    vec<phy_body_*> sleeping_bodies;
+    vec<phy_body_*> wake_list; // scratch for waking many islands at once
     pool<phy_hull_> hulls;
     pool<v2> points;
     array<v2> previous_velocities;
     array<f32> previous_angular_velocities;
     vec<phy_potential_collision_> potential_collisions;
+    vec<phy_narrow_result_> narrow_results; // one for each potential collision
+    vec<phy_narrow_task_> narrow_tasks;
+
+    // incremental broad phase - bodies whose proxies were (re)inserted since
+    // the last broad phase, and the persistent set of pairs whose fat aabbs
+    // overlap, kept sorted by (a, b)
+    vec<phy_body_*> move_buffer;
+    vec<phy_potential_collision_> pairs;
+    vec<phy_potential_collision_> new_pairs;
+    vec<phy_potential_collision_> pair_scratch;
+
+    // scratch space for finding islands, indexed like dynamic_bodies
+    vec<i32> island_parents;
+    vec<f32> island_sleep_times;
+
+    // the contact solver's copy of the collisions, rebuilt every step
+    phy_solver_manifolds_ solver_manifolds;
+    phy_solver_bodies_ solver_bodies;
+    vec<u64> solver_body_colors;    // bit per color using the body, by dynamic_index
+    vec<i32> solver_collision_colors; // indexed like collisions, -1 if not physical
+    vec<phy_solver_color_> solver_colors;
+    vec<phy_solver_task_> solver_tasks;
+
+    // scratch space for building the trees top down
+    vec<i32> build_leaves;
+    vec<i32> build_nodes;
+
     vec<phy_collision_> collisions;
-    hashmap<phy_manifold_> manifold_cache;
+    phy_pair_cache_ pair_cache;
     v2 gravity;
-    phy_aabb_tree_ aabb_tree;
+    v2 wake_gravity; // what the sleeping bodies fell asleep under
+
+    // PHY_FIXED_FLAG bodies live in static_tree, which is only touched when a
+    // fixed body is added or removed. everything else lives in dynamic_tree
+    phy_aabb_tree_ static_tree;
+    phy_aabb_tree_ dynamic_tree;
+
+    phy_broad_phase_ broad_phase;
+    phy_sap_ sap;
+    phy_broad_phase_stats_ broad_phase_stats;
+    b32 broad_phase_switched; // the next step catches up, so isn't counted
+
+    vec<phy_tilemap_*> tilemaps;
     f32 time_step, current_time;
+    i32 velocity_iterations; // solver passes per substep
+
+    phy_solver_ solver;
+    i32 substeps; // per time_step, for soft step
+    phy_softness_ softness;
+
+    // frame time that hasn't been stepped yet, and how far into the next
+    // step it reaches, for drawing bodies between their last two transforms
+    f32 accumulator, interpolation_alpha;
+    u32 snapshot_id;
+    phy_step_policy_ step_policy;
+    i32 max_substeps;
+    f32 max_frame_time; // for PHY_STEP_CLAMP
+    phy_step_stats_ step_stats;
 };
 
 struct ray_intersect_ {
@@ -148,21 +515,101 @@ struct ray_body_intersect_ {
     f32 depth;
 };
 
-phy_aabb_tree_node_* aabb_insert_node(phy_aabb_tree_* tree,
-                                       i32 parent_index,
-                                       phy_aabb_ fat_aabb,
-                                       phy_body_ body,
-                                       b32 is_asleep);
+struct phy_ray_ {
+    v2 p, d;
+    u32 required_flags;
+    phy_body_* exclude;
+};
+
+// up to four rays in structure of arrays form, one per sse lane
+struct phy_ray_packet_ {
+    __m128 p_x, p_y;
+    __m128 inv_d_x, inv_d_y;
+    f32 max_depth[4]; // the closest hit so far. 16 byte aligned after the __m128s
+};
+
+// the two bodies of four manifolds, one per sse lane
+struct phy_lane_bodies_ {
+    __m128 velocity_a_x, velocity_a_y, angular_velocity_a;
+    __m128 velocity_b_x, velocity_b_y, angular_velocity_b;
+    __m128 inv_mass_a, inv_moment_a;
+    __m128 inv_mass_b, inv_moment_b;
+};
+
+i32 aabb_insert_node(phy_aabb_tree_* tree,
+                     phy_aabb_ fat_aabb,
+                     phy_body_* body);
 
 void aabb_remove_node(phy_aabb_tree_ *tree, i32 index);
 
+void aabb_move_node(phy_aabb_tree_* tree, i32 index, phy_aabb_ fat_aabb);
+
+void aabb_optimize_incremental(phy_aabb_tree_* tree, i32 leaf_count);
+
+i32 aabb_tree_height(phy_aabb_tree_* tree);
+
+f32 aabb_tree_cost(phy_aabb_tree_* tree);
+
+void sap_init_intervals(phy_sap_intervals_* intervals,
+                        memory_arena_* memory,
+                        i32 capacity);
+
+void solver_init_manifolds(phy_solver_manifolds_* manifolds,
+                           memory_arena_* memory,
+                           i32 capacity);
+
+void solver_init_bodies(phy_solver_bodies_* bodies,
+                        memory_arena_* memory,
+                        i32 capacity);
+
+void pair_cache_init(phy_pair_cache_* cache, memory_arena_* memory, i32 capacity);
+
+void pair_cache_expire_body(phy_state_* state, phy_body_* body);
+
 b32 aabb_are_intersecting(phy_aabb_ a, phy_aabb_ b);
 
 b32 aabb_is_contained_in(phy_aabb_ inner, phy_aabb_ outer);
 
 void phy_set_gravity(phy_state_* state, v2 gravity);
 
-phy_state_ phy_init(memory_arena_* memory);
+phy_state_ phy_init(memory_arena_* memory, phy_broad_phase_ broad_phase);
+
+// switches how potential collisions are found. which one is faster depends
+// on the scene, so compare them with phy_get_broad_phase_stats, or on fixed
+// scenes with phy_bench_broad_phase
+void phy_set_broad_phase(phy_state_* state, phy_broad_phase_ broad_phase);
+
+phy_broad_phase_stats_ phy_get_broad_phase_stats(phy_state_* state);
+
+// builds each of the bench scenes once per backend out of memory, and steps
+// the two copies side by side, so that both backends see the same bodies on
+// every step. results gets PHY_BENCH_SCENE_COUNT entries. memory is left the
+// way it was found
+void phy_bench_broad_phase(memory_arena_* memory, phy_bench_result_* results);
+
+// hits and misses are for the last full frame
+phy_pair_cache_stats_ phy_get_pair_cache_stats(phy_state_* state);
+
+phy_step_stats_ phy_get_step_stats(phy_state_* state);
+
+// switches solvers along with the time_step to run them at, which for soft
+// step wants to be a good deal longer
+void phy_set_solver(phy_state_* state, phy_solver_ solver, f32 time_step);
+
+// where to draw the body, between where the last step started and ended
+v2 phy_get_render_position(phy_state_* state, phy_body_* body);
+
+f32 phy_get_render_orientation(phy_state_* state, phy_body_* body);
+
+// wakes the body along with every body it fell asleep with
+void phy_wake_body(phy_state_* state, phy_body_* body);
+
+// gives every body added since the last update its proxy right away, building
+// the trees top down in one go. call it after adding a level's worth of bodies
+void phy_add_bodies_bulk(phy_state_* state);
+
+// throws away the internal nodes of both trees and builds them again
+void phy_rebuild_tree(phy_state_* state);
 
 phy_body_* phy_add_block(phy_state_* state,
                           v2 center,
@@ -179,7 +626,20 @@ phy_body_* phy_add_fillet_block(phy_state_* state,
 
 phy_body_ * phy_add_body(phy_state_* state);
 
-void phy_remove_body(phy_state_* state);
+phy_tilemap_* phy_add_tilemap(phy_state_* state,
+                              memory_arena_* memory,
+                              v2 origin,
+                              i32 width,
+                              i32 height,
+                              f32 tile_size,
+                              u32 flags);
+
+void phy_set_tile(phy_tilemap_* tilemap, i32 x, i32 y, b32 solid);
+
+// (re)makes the tilemap's bodies from its solid cells
+void phy_build_tilemap(phy_state_* state, phy_tilemap_* tilemap);
+
+void phy_remove_body(phy_state_* state, phy_body_* body);
 
 array<phy_hull_> phy_add_hulls(phy_state_* state, i32 count);
 
@@ -189,7 +649,13 @@ phy_collision_* phy_add_collision(phy_state_* state);
 
 phy_collision_* phy_add_collision(phy_state_* state, phy_collision_ collision);
 
-void phy_update(phy_state_* state, hashmap<entity_ties_>* collision_map, f32 dt);
+// steps as much of dt as fits in whole time_steps, keeping the rest for the
+// next call. collision_map is cleared whenever at least one step runs. with
+// platform, independent islands get solved in parallel on its task queue
+void phy_update(phy_state_* state,
+                hashmap<entity_ties_>* collision_map,
+                f32 dt,
+                platform_services_* platform = 0);
 
 void phy_add_aabb_for_body(phy_state_* state, phy_body_* body);
 
@@ -208,6 +674,12 @@ ray_body_intersect_ ray_cast(phy_state_* state,
                               u32 required_flags = 0,
                               phy_body_* exclude = 0);
 
+// casts every ray in rays, writing each one's closest hit into results
+void ray_cast_batch(phy_state_* state,
+                    phy_ray_* rays,
+                    i32 count,
+                    ray_body_intersect_* results);
+
 ray_body_intersect_ ray_cast_from_body(phy_state_* state,
                                         phy_body_* self,
                                         f32 width,
@@ -178,6 +178,14 @@ inline i32 iclamp(i32 val, i32 min, i32 max) {
     return (val < min) ? min : ((val > max) ? max : val);
 }
 
+inline i32 i32max(i32 lhs, i32 rhs) {
+    return lhs < rhs ? rhs : lhs;
+}
+
+inline i32 i32min(i32 lhs, i32 rhs) {
+    return lhs < rhs ? lhs : rhs;
+}
+
 inline f32 f32max(f32 lhs, f32 rhs) {
     return lhs < rhs ? rhs : lhs;
 }
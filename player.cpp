@@ -8,7 +8,7 @@ sim_entity_* create_player(game_state_* game_state, v2 position) {
 	const f32 player_mass = 10.0f;
 	const f32 player_initial_orientation = 0.0f;
     const f32 player_z_index = 0.1f;
-    const u32 player_flags = PHY_CHARACTER_FLAG;
+    const u32 player_flags = PHY_CHARACTER_FLAG | PHY_BULLET_FLAG;
 
     sim_entity_* player = create_fillet_block_entity(game_state,
                                                       PLAYER,
@@ -87,7 +87,8 @@ UPDATE_FUNC(PLAYER) {
         }
     }
 
-    game_state->main_camera.center = entity->body->position;
+    game_state->main_camera.center =
+        phy_get_render_position(&game_state->physics_state, entity->body);
     f32 camera_adjustment = -0.1f * fmin(fmax(combined_l_r_trigger, -0.5f), 0.5f);
     game_state->main_camera.orientation = gravity_orientation + camera_adjustment;
 
@@ -167,7 +168,7 @@ UPDATE_FUNC(PLAYER) {
     animation_* animation = game_state->main_animation_group.animations
     	.at(player->animation_index);
 
-    animation->position = entity->body->position;
+    animation->position = phy_get_render_position(&game_state->physics_state, entity->body);
     animation->orientation = gravity_orientation;
     entity->body->orientation = gravity_orientation;
     phy_update_body(&game_state->physics_state, entity->body);
@@ -238,6 +239,7 @@ void kill_player(game_state_* game_state) {
     sim_entity_* player = game_state->player;
     player_state_* player_state = (player_state_*)player->custom_state;
     player->body->position = player_state->save_position;
+    player->body->snapshot_id = 0; // don't draw it sliding back
     player->body->gravity_normal = player_state->save_gravity_normal;
     game_state->rotation_state = player_state->save_rotation_state;
 
@@ -20,6 +20,7 @@ enum entity_type {
     SPIKES,
     SAVE_POINT,
     LILGUY,
+    TILEMAP,
 };
 
 #define UPDATE_FUNC(type) void update_##type(game_state_* game_state,\
@@ -45,6 +46,7 @@ struct aabb_ {
 };
 
 struct tile_info_ {
+    v2 position; // tiles in the tilemap don't get their own body
     i32 tex_coord_x;
     i32 tex_coord_y;
 };
@@ -1,34 +1,27 @@
 #include "sim_entity.h"
 
-const v2 tile_diagonal = v2 {1.0f, 1.0f};
 const f32 tile_z = 0.15f;
 const i32 tile_texture_size = 64;
 const f32 spikes_z = tile_z;
 const i32 spikes_texture_size = tile_texture_size;
 
+// only draws. the tile's collision comes from the level's tilemap
 sim_entity_*
 create_tile(game_state_* game_state, v2 position, tile_info_ info) {
-
-    const f32 tile_mass = 100.0f;
-    const f32 tile_orientation = 0.0f;
-
-    sim_entity_* tile = create_block_entity(game_state,
-                                             TILE,
-                                             position,
-                                             tile_diagonal,
-                                             tile_mass,
-                                             tile_orientation,
-                                             PHY_FIXED_FLAG | PHY_GROUND_FLAG);
-
-    tile->body->inv_moment = 0.0f;
-    tile->body->inv_mass = 0.0f;
+    sim_entity_* tile = add_entity(game_state);
+    tile->body = 0;
+    tile->type = TILE;
     tile->tile_info = info;
+    tile->tile_info.position = position;
 
     return tile;
 }
 
 UPDATE_FUNC(TILE) {
     phy_body_* body = entity->body;
+    phy_state_* physics = &game_state->physics_state;
+    v2 position = body ? phy_get_render_position(physics, body) : entity->tile_info.position;
+    f32 orientation = body ? phy_get_render_orientation(physics, body) : 0.0f;
 
     rect_i source_rect;
     source_rect.min_x = entity->tile_info.tex_coord_x * tile_texture_size;
@@ -37,13 +30,13 @@ UPDATE_FUNC(TILE) {
     source_rect.max_y = source_rect.min_y + tile_texture_size;
 
     push_texture(&game_state->main_render_group,
-                 body->position,
+                 position,
                  v2 {32.0f, 32.0f},
                  VIRTUAL_PIXEL_SIZE,
                  game_state->terrain_1,
                  source_rect,
                  rgba_{0},
-                 body->orientation,
+                 orientation,
                  tile_z);
 }
 
@@ -91,6 +84,9 @@ create_spikes(game_state_* game_state, v2 position, i32 direction) {
 
 UPDATE_FUNC(SPIKES) {
     phy_body_* body = entity->body;
+    phy_state_* physics = &game_state->physics_state;
+    v2 position = phy_get_render_position(physics, body);
+    f32 orientation = phy_get_render_orientation(physics, body);
 
     rect_i source_rect;
     source_rect.min_x = entity->spikes_info.direction * spikes_texture_size;
@@ -101,16 +97,16 @@ UPDATE_FUNC(SPIKES) {
     v2 center;
     switch (entity->spikes_info.direction) {
         case DIR_UP: {
-            center = body->position + v2 {0.0f, 0.25f};
+            center = position + v2 {0.0f, 0.25f};
         } break;
         case DIR_DOWN: {
-            center = body->position - v2 {0.0f, 0.25f};
+            center = position - v2 {0.0f, 0.25f};
         } break;
         case DIR_LEFT: {
-            center = body->position + v2 {0.25f, 0.0f};
+            center = position + v2 {0.25f, 0.0f};
         } break;
         case DIR_RIGHT: {
-            center = body->position - v2 {0.25f, 0.0f};
+            center = position - v2 {0.25f, 0.0f};
         } break;
     }
 
@@ -121,7 +117,7 @@ UPDATE_FUNC(SPIKES) {
                  game_state->terrain_1,
                  source_rect,
                  rgba_{0},
-                 body->orientation,
+                 orientation,
                  spikes_z);
 
 
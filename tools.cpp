@@ -1,6 +1,34 @@
 #include "util.h"
 #include "renderer.h"
 
+// steps the bench scenes with both broad phases and prints what each cost.
+// it builds its own scenes, so the game's physics state isn't touched
+void run_broad_phase_bench() {
+    const char* scene_names[PHY_BENCH_SCENE_COUNT] = {"corridor", "pile"};
+
+    memory_arena_ scratch;
+    scratch.size = 1024 * 1024 * 64;
+    scratch.used = 0;
+    scratch.base = (u8*)calloc(scratch.size, 1);
+
+    phy_bench_result_ results[PHY_BENCH_SCENE_COUNT];
+    phy_bench_broad_phase(&scratch, results);
+    free(scratch.base);
+
+    for (i32 i = 0; i < PHY_BENCH_SCENE_COUNT; ++i) {
+        phy_bench_result_* result = results + i;
+        printf("%s, %d steps: tree %.0f cycles/step, %lld pairs. "
+               "sap %.0f cycles/step, %lld pairs. %d steps mismatched\n",
+               scene_names[i],
+               result->steps,
+               (f64)result->cycles[PHY_BROAD_PHASE_TREE] / result->steps,
+               (long long)result->pairs[PHY_BROAD_PHASE_TREE],
+               (f64)result->cycles[PHY_BROAD_PHASE_SAP] / result->steps,
+               (long long)result->pairs[PHY_BROAD_PHASE_SAP],
+               result->mismatched_steps);
+    }
+}
+
 void tools_init(tools_state_* tools_state) {
     debug_init(tools_state);
 
@@ -15,7 +43,7 @@ void tools_init(tools_state_* tools_state) {
     main_menu->offset = v2 {0.0f, 0.0f};
     main_menu->size = v2 {0.0f, 0.0f};
     main_menu->menu.active = false;
-    i32 main_menu_item_count = 5;
+    i32 main_menu_item_count = 8;
     main_menu->menu.children = tools_state->ui_elements.push_many(main_menu_item_count);
     main_menu->menu.child_count = main_menu_item_count;
 
@@ -43,10 +71,28 @@ void tools_init(tools_state_* tools_state) {
     performance_toggle->offset = v2 {8.0f, 152.0f};
     performance_toggle->size = v2 {40.0f, 40.0f};
 
-    ui_element_* draggable = &main_menu->menu.children[4];
+    ui_element_* broad_phase_toggle = &main_menu->menu.children[4];
+    broad_phase_toggle->type = UI_TOGGLE_BROAD_PHASE;
+    broad_phase_toggle->parent = main_menu;
+    broad_phase_toggle->offset = v2 {8.0f, 200.0f};
+    broad_phase_toggle->size = v2 {40.0f, 40.0f};
+
+    ui_element_* solver_toggle = &main_menu->menu.children[5];
+    solver_toggle->type = UI_TOGGLE_SOLVER;
+    solver_toggle->parent = main_menu;
+    solver_toggle->offset = v2 {8.0f, 248.0f};
+    solver_toggle->size = v2 {40.0f, 40.0f};
+
+    ui_element_* broad_phase_bench = &main_menu->menu.children[6];
+    broad_phase_bench->type = UI_RUN_BROAD_PHASE_BENCH;
+    broad_phase_bench->parent = main_menu;
+    broad_phase_bench->offset = v2 {8.0f, 296.0f};
+    broad_phase_bench->size = v2 {40.0f, 40.0f};
+
+    ui_element_* draggable = &main_menu->menu.children[7];
     draggable->type = UI_DRAGGABLE_WIDGET;
     draggable->parent = main_menu;
-    draggable->offset = v2 {8.0f, 200.0f};
+    draggable->offset = v2 {8.0f, 344.0f};
     draggable->size = v2 {208.0f, 208.0f};
 
     ui_element_* color_picker = draggable->draggable_widget.child =
@@ -160,6 +206,21 @@ void draw_tools_menu(game_state_* game_state,
                           hovering ? color_ {0.2f, 0.2f, 0.6f} : color_ {0.0f, 0.0f, 0.6f},
                           draw_rect);
             } break;
+            case UI_TOGGLE_BROAD_PHASE: {
+                push_rect(&game_state->ui_render_group,
+                          hovering ? color_ {0.6f, 0.6f, 0.2f} : color_ {0.6f, 0.6f, 0.0f},
+                          draw_rect);
+            } break;
+            case UI_TOGGLE_SOLVER: {
+                push_rect(&game_state->ui_render_group,
+                          hovering ? color_ {0.2f, 0.6f, 0.6f} : color_ {0.0f, 0.6f, 0.6f},
+                          draw_rect);
+            } break;
+            case UI_RUN_BROAD_PHASE_BENCH: {
+                push_rect(&game_state->ui_render_group,
+                          hovering ? color_ {0.6f, 0.2f, 0.6f} : color_ {0.6f, 0.0f, 0.6f},
+                          draw_rect);
+            } break;
             case UI_COLOR_PICKER: {
                 push_color_picker(&game_state->ui_render_group,
                                   item.element->color_picker.hsv,
@@ -291,6 +352,24 @@ void tools_update_and_render(game_state_* game_state,
                     tools_state->debug_state.show_performance =
                         !tools_state->debug_state.show_performance;
                 } break;
+                case UI_TOGGLE_BROAD_PHASE: {
+                    phy_state_* physics = &game_state->physics_state;
+                    phy_set_broad_phase(physics,
+                                        physics->broad_phase == PHY_BROAD_PHASE_TREE
+                                        ? PHY_BROAD_PHASE_SAP
+                                        : PHY_BROAD_PHASE_TREE);
+                } break;
+                case UI_TOGGLE_SOLVER: {
+                    phy_state_* physics = &game_state->physics_state;
+                    if (physics->solver == PHY_SOLVER_BAUMGARTE) {
+                        phy_set_solver(physics, PHY_SOLVER_SOFT_STEP, SOFT_STEP_TIME_STEP);
+                    } else {
+                        phy_set_solver(physics, PHY_SOLVER_BAUMGARTE, SOLVER_TIME_STEP);
+                    }
+                } break;
+                case UI_RUN_BROAD_PHASE_BENCH: {
+                    run_broad_phase_bench();
+                } break;
             }
         } else {
             glBindFramebuffer(GL_READ_FRAMEBUFFER,
@@ -14,6 +14,9 @@ enum ui_element_type_ {
     UI_TOGGLE_WIREFRAMES,
     UI_TOGGLE_AABB_TREE,
     UI_TOGGLE_PERFORMANCE,
+    UI_TOGGLE_BROAD_PHASE,
+    UI_TOGGLE_SOLVER,
+    UI_RUN_BROAD_PHASE_BENCH,
     UI_COLOR_PICKER,
 };
 
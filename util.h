@@ -18,6 +18,14 @@ void* _push_size(memory_arena_* arena, size_t size) {
     return result;
 };
 
+// alignment must be a power of two
+void* _push_size_aligned(memory_arena_* arena, size_t size, size_t alignment) {
+    size_t address = (size_t)(arena->base + arena->used);
+    size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    _push_size(arena, padding);
+    return _push_size(arena, size);
+};
+
 const i32 SMALL_STACK_SIZE = 256;
 const i32 MEDIUM_STACK_SIZE = 1024;
 const i32 LARGE_STACK_SIZE = 1024 * 32;
@@ -25,6 +33,7 @@ const i32 LARGE_STACK_SIZE = 1024 * 32;
 #define ARRAY_SIZE(array) (sizeof(array) / sizeof(array[0]))
 #define PUSH_STRUCT(arena, type) (type *)_push_size(arena, sizeof(type))
 #define PUSH_ARRAY(arena, count, type) (type *)_push_size(arena, ((size_t)count) * sizeof(type))
+#define PUSH_ARRAY_ALIGNED(arena, count, type, alignment) (type *)_push_size_aligned(arena, ((size_t)count) * sizeof(type), alignment)
 #define ZERO_STRUCT(instance) memset(&(instance), 0, sizeof(instance))
 #define ZERO_ARRAY(instance, count) memset(instance, 0, ((size_t)count) * sizeof(*instance))
 
@@ -39,6 +48,11 @@ struct vec {
     this->count = 0;
     this->values = PUSH_ARRAY(memory, cap, T);
   }
+  inline void init(memory_arena_* memory, i32 cap, size_t alignment) {
+    this->capacity = cap;
+    this->count = 0;
+    this->values = PUSH_ARRAY_ALIGNED(memory, cap, T, alignment);
+  }
   inline T& operator[] (i32 index) { return this->values[index]; }
   inline T* at(i32 index) { return this->values + index; }
   inline T* push(T val) {